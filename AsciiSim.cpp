@@ -0,0 +1,66 @@
+#include "AsciiSim.hpp"
+#include "Profiler.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+bool AsciiSim::ReadInfo(const std::string& infoPath, int& frames, int& x, int& y, int& z) {
+    std::ifstream infoFile(infoPath);
+    if (!infoFile.is_open())
+        return false;
+
+    infoFile >> frames >> x >> y >> z;
+    return !infoFile.fail();
+}
+
+std::string AsciiSim::FramePath(const std::string& infoPath, int frame) {
+    std::filesystem::path dirPath = std::filesystem::path(infoPath).parent_path();
+    return (dirPath / ("frame" + std::to_string(frame))).string();
+}
+
+bool AsciiSim::ReadFrame(const std::string& framePath, VoxelGrid<float>& grid) {
+    PROFILE_SCOPE("AsciiSim::ReadFrame");
+
+    std::ifstream frameFile(framePath);
+    if (!frameFile.is_open())
+        return false;
+
+    for (int k = 0; k < grid.Depth(); ++k)
+        for (int j = 0; j < grid.Height(); ++j)
+            for (int i = 0; i < grid.Width(); ++i) {
+                double density = 0.0;
+                float fdensity = 0.0f;
+                frameFile >> density;
+                if (density > 0)
+                    fdensity = static_cast<float>(density);
+                grid.At(i, j, k) = fdensity;
+            }
+    return true;
+}
+
+bool AsciiSim::Write(const std::string& dir, const std::vector<VoxelGrid<float>>& frames) {
+    std::filesystem::create_directories(dir);
+    if (frames.empty())
+        return false;
+
+    const VoxelGrid<float>& first = frames.front();
+    std::string infoPath = (std::filesystem::path(dir) / "info.sim").string();
+    std::ofstream info(infoPath);
+    info << frames.size() << " " << first.Width() << " " << first.Height() << " " << first.Depth() << "\n";
+    if (!info.good())
+        return false;
+
+    for (size_t f = 0; f < frames.size(); ++f) {
+        std::ofstream out(FramePath(infoPath, static_cast<int>(f)));
+        const VoxelGrid<float>& grid = frames[f];
+        for (int k = 0; k < grid.Depth(); ++k)
+            for (int j = 0; j < grid.Height(); ++j) {
+                for (int i = 0; i < grid.Width(); ++i)
+                    out << grid.At(i, j, k) << ' ';
+                out << '\n';
+            }
+        if (!out.good())
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "VoxelGrid.hpp"
+
+// The plain-text simulation format: an info.sim holding
+// "frames width height depth", and beside it files frame0, frame1, ...
+// each listing width*height*depth densities, x fastest, then y, then z.
+namespace AsciiSim {
+    bool ReadInfo(const std::string& infoPath, int& frames, int& x, int& y, int& z);
+    std::string FramePath(const std::string& infoPath, int frame);
+
+    // Parses one frame into `grid`, which must already have the frame's
+    // dimensions. Negative densities are read as zero.
+    bool ReadFrame(const std::string& framePath, VoxelGrid<float>& grid);
+
+    // Writes info.sim and one file per frame into `dir`.
+    bool Write(const std::string& dir, const std::vector<VoxelGrid<float>>& frames);
+}
@@ -0,0 +1,728 @@
+//
+// Benchmark.cpp
+//
+// Headless benchmarks for the load and playback pipeline. For each requested
+// resolution a synthetic smoke sequence is generated from a fixed seed, so
+// every run times identical work, and each stage is timed over a few repeats.
+// Results are printed as JSON for regression tracking.
+//
+
+#include "AsciiSim.hpp"
+#include "BrickMask.hpp"
+#include "CpuRenderer.hpp"
+#include "FrameBlend.hpp"
+#include "ParallelFor.hpp"
+#include "ParticleSplat.hpp"
+#include "ParticleSystem.hpp"
+#include "ProgressiveRenderer.hpp"
+#include "Profiler.hpp"
+#include "SdfBake.hpp"
+#include "SdfScene.hpp"
+#include "SimFile.hpp"
+#include "SmokeForces.hpp"
+#include "SmokeSolver.hpp"
+#include "TemporalRenderer.hpp"
+#include "TransferFunction.hpp"
+#include "VoxelGrid.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::vector<std::array<int, 3>> resolutions = { { 32, 64, 32 }, { 64, 128, 64 } };
+    int frames = 16;
+    int particles = 1000000;
+    int obstacles = 256;
+    int repeats = 3;
+    int imageWidth = 250, imageHeight = 200;
+    float stepSize = 0.004f;
+    unsigned seed = 1234;
+    std::string dir = (std::filesystem::temp_directory_path() / "smoke_benchmark").string();
+    std::string out;   // JSON file, stdout if empty
+    std::string trace; // Chrome trace file, none if empty
+    bool help = false;
+};
+
+struct Result {
+    std::string name;
+    std::array<int, 3> resolution;
+    double bestMs = 0.0;
+    double medianMs = 0.0;
+    double throughput = 0.0; // Per second, at the best time
+    std::string unit;
+    double rmse = -1.0;       // Against a reference image, for render stages that have one
+    double voxelError = -1.0; // RMS distance error in voxels, for distance-field bakes
+};
+
+void PrintUsage() {
+    std::cerr <<
+        "Usage: Benchmark [options]\n"
+        "  --res WxHxD[,WxHxD...]  volume resolutions (default 32x64x32,64x128x64)\n"
+        "  --frames N              frames per sequence (default 16)\n"
+        "  --particles N           tracer particles advected per step (default 1000000)\n"
+        "  --obstacles N           SDF objects in the obstacle scene (default 256)\n"
+        "  --repeats N             timed runs per stage, best and median reported (default 3)\n"
+        "  --image WxH             CPU raymarch image size (default 250x200)\n"
+        "  --step S                CPU raymarch step size (default 0.004)\n"
+        "  --seed N                synthetic sequence seed (default 1234)\n"
+        "  --dir PATH              scratch directory for generated files\n"
+        "  --out PATH              write JSON here instead of stdout\n"
+        "  --trace PATH            also record a Chrome trace of the run\n"
+        "  --help, -h              print this and exit\n";
+}
+
+bool ParseResolution(const std::string& text, std::array<int, 3>& res) {
+    return std::sscanf(text.c_str(), "%dx%dx%d", &res[0], &res[1], &res[2]) == 3 && res[0] > 0 && res[1] > 0 && res[2] > 0;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            options.help = true;
+            return true;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--res") {
+            options.resolutions.clear();
+            std::stringstream list(value);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                std::array<int, 3> res;
+                if (!ParseResolution(item, res)) {
+                    std::cerr << "Bad resolution " << item << "\n";
+                    return false;
+                }
+                options.resolutions.push_back(res);
+            }
+        }
+        else if (arg == "--frames") options.frames = std::max(2, std::atoi(value.c_str()));
+        else if (arg == "--particles") options.particles = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--obstacles") options.obstacles = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--repeats") options.repeats = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--image") {
+            if (std::sscanf(value.c_str(), "%dx%d", &options.imageWidth, &options.imageHeight) != 2 ||
+                options.imageWidth <= 0 || options.imageHeight <= 0) {
+                std::cerr << "Bad image size " << value << "\n";
+                return false;
+            }
+        }
+        else if (arg == "--step") options.stepSize = static_cast<float>(std::atof(value.c_str()));
+        else if (arg == "--seed") options.seed = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (arg == "--dir") options.dir = value;
+        else if (arg == "--out") options.out = value;
+        else if (arg == "--trace") options.trace = value;
+        else {
+            std::cerr << "Unknown option " << arg << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// A handful of Gaussian puffs rising from the floor and spreading out, with
+// a little per-voxel grain so nothing compresses or skips trivially
+std::vector<VoxelGrid<float>> GenerateSequence(int x, int y, int z, int frames, unsigned seed) {
+    struct Puff {
+        float px, py, pz;
+        float vx, vy, vz;
+        float radius, growth, amount;
+    };
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<Puff> puffs(6);
+    for (Puff& p : puffs) {
+        p.px = x * (0.3f + 0.4f * unit(rng));
+        p.py = y * (0.05f + 0.15f * unit(rng));
+        p.pz = z * (0.3f + 0.4f * unit(rng));
+        p.vx = (unit(rng) - 0.5f) * 0.02f * x;
+        p.vy = (0.02f + 0.03f * unit(rng)) * y;
+        p.vz = (unit(rng) - 0.5f) * 0.02f * z;
+        p.radius = x * (0.06f + 0.06f * unit(rng));
+        p.growth = p.radius * 0.05f;
+        p.amount = 0.5f + 0.5f * unit(rng);
+    }
+
+    std::vector<VoxelGrid<float>> sequence;
+    sequence.reserve(frames);
+    for (int f = 0; f < frames; ++f) {
+        VoxelGrid<float> grid(x, y, z);
+        ParallelFor(z, [&](int z0, int z1) {
+            for (int k = z0; k < z1; ++k)
+                for (int j = 0; j < y; ++j)
+                    for (int i = 0; i < x; ++i) {
+                        float d = 0.0f;
+                        for (const Puff& p : puffs) {
+                            float r = p.radius + p.growth * f;
+                            float dx = i - (p.px + p.vx * f), dy = j - (p.py + p.vy * f), dz = k - (p.pz + p.vz * f);
+                            float q = (dx * dx + dy * dy + dz * dz) / (r * r);
+                            if (q < 9.0f)
+                                d += p.amount * std::exp(-q);
+                        }
+                        if (d > 1e-3f) {
+                            // Cheap hash grain, +-10%
+                            uint32_t h = static_cast<uint32_t>(i * 73856093 ^ j * 19349663 ^ k * 83492791 ^ f * 2654435761u);
+                            h ^= h >> 13;
+                            h *= 0x5bd1e995;
+                            d *= 0.9f + 0.2f * (h & 0xffff) / 65535.0f;
+                        }
+                        grid.At(i, j, k) = d;
+                    }
+        });
+        sequence.push_back(std::move(grid));
+    }
+    return sequence;
+}
+
+// Small boxes, spheres and capsules scattered through the volume box at
+// random orientations; every fourth has a sphere carved out of it and
+// every fifth a capsule blended on
+SdfScene GenerateObstacles(int count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    SdfScene scene;
+    for (int i = 0; i < count; ++i) {
+        SdfObject object;
+        object.transform.position = Vector3(unit(rng) - 0.5f, unit(rng) * 2.0f - 1.0f, unit(rng) - 0.5f);
+        object.transform.rotation = Vector3(unit(rng), unit(rng), unit(rng)) * 6.2831853f;
+        object.color = Vector3(0.4f + 0.4f * unit(rng), 0.4f + 0.4f * unit(rng), 0.4f + 0.4f * unit(rng));
+
+        SdfPrimitive base;
+        base.shape = static_cast<SdfShape>(i % 3);
+        base.size = Vector3(0.01f + 0.02f * unit(rng), 0.01f + 0.02f * unit(rng), 0.01f + 0.02f * unit(rng));
+        object.primitives.push_back(base);
+        if (i % 4 == 0) {
+            SdfPrimitive hole;
+            hole.shape = SdfShape::Sphere;
+            hole.size = Vector3(base.size.x, 0.0f, 0.0f);
+            hole.transform.position = Vector3(base.size.x, 0.0f, 0.0f);
+            hole.op = SdfOp::Subtract;
+            object.primitives.push_back(hole);
+        }
+        if (i % 5 == 0) {
+            SdfPrimitive handle;
+            handle.shape = SdfShape::Capsule;
+            handle.size = Vector3(0.005f, 0.03f, 0.0f);
+            handle.transform.rotation = Vector3(1.5707963f, 0.0f, 0.0f);
+            handle.blend = 0.01f;
+            object.primitives.push_back(handle);
+        }
+        scene.objects.push_back(object);
+    }
+    scene.Build();
+    return scene;
+}
+
+// Brown smoke with a thin, bright and dense shell around one density, which
+// a coarse step can cross between two samples
+TransferFunction SharpTransfer() {
+    TransferFunction tf;
+    tf.points.push_back({ 0.0f, Vector3(0.6f, 0.4f, 0.2f), 0.0f });
+    tf.points.push_back({ 0.3f, Vector3(0.6f, 0.4f, 0.2f), 0.5f });
+    tf.points.push_back({ 0.32f, Vector3(1.0f, 0.9f, 0.6f), 40.0f });
+    tf.points.push_back({ 0.34f, Vector3(0.6f, 0.4f, 0.2f), 0.5f });
+    tf.points.push_back({ 1.0f, Vector3(0.6f, 0.4f, 0.2f), 2.0f });
+    return tf;
+}
+
+// `setup`, if given, runs untimed before each repeat
+Result Measure(const std::string& name, const std::array<int, 3>& res, int repeats, double work, const std::string& unit,
+    const std::function<void()>& body, const std::function<void()>& setup = nullptr) {
+    std::vector<double> ms;
+    for (int r = 0; r < repeats; ++r) {
+        if (setup)
+            setup();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(ms.begin(), ms.end());
+
+    Result result;
+    result.name = name;
+    result.resolution = res;
+    result.bestMs = ms.front();
+    result.medianMs = ms[ms.size() / 2];
+    result.throughput = result.bestMs > 0.0 ? work / (result.bestMs / 1000.0) : 0.0;
+    result.unit = unit;
+    std::cerr << name << " " << res[0] << "x" << res[1] << "x" << res[2] << ": " << result.bestMs << " ms, "
+        << result.throughput << " " << unit << "\n";
+    return result;
+}
+
+void RunResolution(const Options& options, const std::array<int, 3>& res, std::vector<Result>& results) {
+    const int x = res[0], y = res[1], z = res[2];
+    const int frames = options.frames;
+    const double voxels = static_cast<double>(x) * y * z * frames;
+    const double megaVoxels = voxels / 1e6;
+
+    std::vector<VoxelGrid<float>> sequence = GenerateSequence(x, y, z, frames, options.seed);
+
+    std::string name = std::to_string(x) + "x" + std::to_string(y) + "x" + std::to_string(z);
+    std::filesystem::path dir = std::filesystem::path(options.dir) / name;
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    // ASCII parse
+    std::string infoPath = (dir / "info.sim").string();
+    AsciiSim::Write(dir.string(), sequence);
+    results.push_back(Measure("ascii_parse", res, options.repeats, megaVoxels, "Mvoxel/s", [&]() {
+        int count, w, h, d;
+        AsciiSim::ReadInfo(infoPath, count, w, h, d);
+        VoxelGrid<float> grid(w, h, d);
+        for (int f = 0; f < count; ++f)
+            AsciiSim::ReadFrame(AsciiSim::FramePath(infoPath, f), grid);
+    }));
+
+    // Binary container load
+    std::string containerPath = (dir / "sequence.smk").string();
+    {
+        SimFileWriter writer;
+        writer.Open(containerPath, x, y, z);
+        for (int f = 0; f < frames; ++f)
+            writer.WriteFrame(f, sequence[f]);
+        writer.Close();
+    }
+    const double megaBytes = voxels * sizeof(float) / (1024.0 * 1024.0);
+    results.push_back(Measure("binary_load", res, options.repeats, megaBytes, "MB/s", [&]() {
+        SimFileReader reader;
+        reader.Open(containerPath);
+        VoxelGrid<float> grid(x, y, z);
+        for (int f = 0; f < reader.FrameCount(); ++f)
+            reader.ReadFrame(f, grid);
+    }));
+
+    // Brick occupancy
+    BrickMask mask(x, y, z);
+    results.push_back(Measure("occupancy_build", res, options.repeats, megaVoxels, "Mvoxel/s", [&]() {
+        for (const VoxelGrid<float>& frame : sequence)
+            mask.Mark(frame, 1e-4f);
+    }));
+
+    // Frame interpolation
+    VoxelGrid<float> blended(x, y, z);
+    const double blendVoxels = static_cast<double>(x) * y * z * (frames - 1) / 1e6;
+    results.push_back(Measure("interpolation", res, options.repeats, blendVoxels, "Mvoxel/s", [&]() {
+        for (int f = 0; f + 1 < frames; ++f)
+            BlendFrames(sequence[f], sequence[f + 1], 0.5f, blended);
+    }));
+
+    // Vorticity confinement and buoyancy on a swirl rising through the
+    // middle frame's smoke, fused against the three-pass reference. Bytes are
+    // ForceStats' nominal traffic, so the GB/s figures compare the passes
+    // rather than measure the memory bus.
+    {
+        SmokeFields swirl(x, y, z);
+        for (int k = 0; k < z; ++k)
+            for (int j = 0; j < y; ++j)
+                for (int i = 0; i < x; ++i) {
+                    float dx = i - 0.5f * (x - 1), dz = k - 0.5f * (z - 1);
+                    float turn = std::sin(6.2831853f * j / y);
+                    swirl.u.At(i, j, k) = -0.2f * dz * turn;
+                    swirl.v.At(i, j, k) = 2.0f * sequence[frames / 2].At(i, j, k);
+                    swirl.w.At(i, j, k) = 0.2f * dx * turn;
+                }
+        swirl.density = sequence[frames / 2];
+        swirl.temperature = sequence[frames / 2];
+
+        SmokeForces forces;
+        SmokeFields fused = swirl, unfused = swirl;
+        forces.Apply(fused, 0.1f);
+        const double fusedBytes = forces.LastStats().bytes;
+        forces.ApplyUnfused(unfused, 0.1f);
+        const double unfusedBytes = forces.LastStats().bytes;
+        const bool identical = fused.u.Size() == unfused.u.Size()
+            && std::equal(fused.u.Data(), fused.u.Data() + fused.u.Size(), unfused.u.Data())
+            && std::equal(fused.v.Data(), fused.v.Data() + fused.v.Size(), unfused.v.Data())
+            && std::equal(fused.w.Data(), fused.w.Data() + fused.w.Size(), unfused.w.Data());
+
+        results.push_back(Measure("forces_fused", res, options.repeats, fusedBytes / 1e9, "GB/s nominal", [&]() {
+            forces.Apply(fused, 0.1f);
+        }, [&]() { fused = swirl; }));
+        results.push_back(Measure("forces_unfused", res, options.repeats, unfusedBytes / 1e9, "GB/s nominal", [&]() {
+            forces.ApplyUnfused(unfused, 0.1f);
+        }, [&]() { unfused = swirl; }));
+        std::cerr << "  nominal MB per step: fused " << fusedBytes / 1e6 << ", unfused " << unfusedBytes / 1e6
+            << (identical ? "; results identical\n" : "; results DIFFER\n");
+    }
+
+    // CPU raymarch of the middle frame
+    CpuRenderer renderer;
+    renderer.settings.stepSize = options.stepSize;
+    CpuImage image;
+    image.Resize(options.imageWidth, options.imageHeight);
+    const VoxelGrid<float>& middle = sequence[frames / 2];
+    renderer.Render(middle, image); // Sample count for the throughput figure
+    double megaSamples = renderer.LastStats().samples / 1e6;
+    results.push_back(Measure("raymarch", res, options.repeats, megaSamples, "Msample/s", [&]() {
+        renderer.Render(middle, image);
+    }));
+    const CpuRenderStats fixedStats = renderer.LastStats();
+
+    // The same with the cube sphere-traced first and the smoke marched only
+    // up to it, against testing the cube at every sample
+    auto printPerRay = [](const char* label, const CpuRenderStats& fixed, const CpuRenderStats& traced) {
+        std::cerr << "  " << label << " per ray: samples " << static_cast<double>(fixed.samples) / fixed.rays << " -> "
+            << static_cast<double>(traced.samples) / traced.rays << ", solid steps "
+            << static_cast<double>(fixed.solidSteps) / fixed.rays << " -> " << static_cast<double>(traced.solidSteps) / traced.rays
+            << "\n";
+    };
+    renderer.settings.sphereTrace = true;
+    renderer.Render(middle, image);
+    results.push_back(Measure("raymarch_traced", res, options.repeats, renderer.LastStats().samples / 1e6, "Msample/s", [&]() {
+        renderer.Render(middle, image);
+    }));
+    printPerRay("cube", fixedStats, renderer.LastStats());
+    renderer.settings.sphereTrace = false;
+
+    // Transfer-function shading at four times the step, where the
+    // pre-integrated table is meant to hold up, scored against the 1D table
+    // at a quarter of the step. The transfer function has a thin, dense
+    // shell that a coarse step can cross between two samples; smooth ones
+    // such as Default() show no difference between the modes.
+    {
+        TransferFunction transfer = SharpTransfer();
+        CpuRenderer shaded;
+        shaded.settings.drawCube = false;
+        shaded.settings.transfer = &transfer;
+        shaded.settings.shading = SmokeShading::Transfer;
+        shaded.settings.stepSize = options.stepSize * 0.25f;
+        transfer.Bake(shaded.settings.stepSize);
+        CpuImage truth;
+        truth.Resize(options.imageWidth, options.imageHeight);
+        shaded.Render(middle, truth);
+
+        transfer.Bake(options.stepSize * 4.0f);
+        shaded.settings.stepSize = options.stepSize * 4.0f;
+        for (SmokeShading shading : { SmokeShading::Transfer, SmokeShading::PreIntegrated }) {
+            shaded.settings.shading = shading;
+            shaded.Render(middle, image);
+            double shadedSamples = shaded.LastStats().samples / 1e6;
+            const char* stageName = shading == SmokeShading::Transfer ? "raymarch_transfer" : "raymarch_preintegrated";
+            results.push_back(Measure(stageName, res, options.repeats, shadedSamples, "Msample/s", [&]() {
+                shaded.Render(middle, image);
+            }));
+            double sum = 0.0;
+            size_t count = 0;
+            for (size_t p = 0; p < image.rgba.size(); p += 4)
+                for (int c = 0; c < 3; ++c, ++count)
+                    sum += std::pow(image.rgba[p + c] - truth.rgba[p + c], 2.0);
+            results.back().rmse = std::sqrt(sum / count);
+        }
+        std::cerr << "  rmse at 4x step: transfer " << results[results.size() - 2].rmse << ", pre-integrated "
+            << results.back().rmse << "\n";
+    }
+
+    // Progressive refinement after a camera move: time to the preview, then
+    // to the image matching the full-step march
+    ProgressiveRenderer progressive;
+    progressive.settings.stepSize = options.stepSize;
+    results.push_back(Measure("progressive_first", res, options.repeats, 1.0, "image/s", [&]() {
+        progressive.Restart(true);
+        progressive.Render(middle, image);
+    }));
+    results.push_back(Measure("progressive_converged", res, options.repeats, 1.0, "image/s", [&]() {
+        progressive.Restart(true);
+        while (progressive.Render(middle, image))
+            ;
+    }));
+
+    // Temporal accumulation over a slow orbit against plain marching at the
+    // same coarse step, at 4x the step (about half a voxel at 32x64x32, well
+    // sampled) and 16x (undersampled). Both are scored on the last frames
+    // against a march at a quarter of the step. The cube is left out: its
+    // outline at a coarse step is a sample-test miss on thin chords, not
+    // sampling noise, and would otherwise make up nearly all of the error.
+    {
+        const int orbitFrames = 16, scoredFrames = 4;
+        auto orbit = [](int f) {
+            Camera camera;
+            camera.Rotate(0.005f * f, 0.001f * f);
+            return camera;
+        };
+        CpuRenderer reference;
+        reference.settings.stepSize = options.stepSize * 0.25f;
+        reference.settings.drawCube = false;
+        std::vector<CpuImage> truth(scoredFrames);
+        for (int i = 0; i < scoredFrames; ++i) {
+            truth[i].Resize(options.imageWidth, options.imageHeight);
+            reference.settings.camera = orbit(orbitFrames - scoredFrames + i);
+            reference.Render(middle, truth[i]);
+        }
+        auto rmse = [&](const std::vector<CpuImage>& frames) {
+            double sum = 0.0;
+            size_t count = 0;
+            for (int i = 0; i < scoredFrames; ++i)
+                for (size_t p = 0; p < frames[i].rgba.size(); p += 4)
+                    for (int c = 0; c < 3; ++c, ++count)
+                        sum += std::pow(frames[i].rgba[p + c] - truth[i].rgba[p + c], 2.0);
+            return std::sqrt(sum / count);
+        };
+
+        for (int factor : { 4, 16 }) {
+            const std::string suffix = factor == 4 ? "" : "_" + std::to_string(factor) + "x";
+            std::vector<CpuImage> scored(scoredFrames, image);
+            CpuRenderer coarse;
+            coarse.settings.stepSize = options.stepSize * factor;
+            coarse.settings.drawCube = false;
+            results.push_back(Measure("raymarch_coarse" + suffix, res, options.repeats, orbitFrames, "frame/s", [&]() {
+                for (int f = 0; f < orbitFrames; ++f) {
+                    coarse.settings.camera = orbit(f);
+                    coarse.Render(middle, image);
+                    if (f >= orbitFrames - scoredFrames)
+                        scored[f - (orbitFrames - scoredFrames)] = image;
+                }
+            }));
+            results.back().rmse = rmse(scored);
+
+            TemporalRenderer temporal;
+            temporal.settings.stepSize = coarse.settings.stepSize;
+            temporal.settings.drawCube = false;
+            results.push_back(Measure("temporal_reprojection" + suffix, res, options.repeats, orbitFrames, "frame/s", [&]() {
+                for (int f = 0; f < orbitFrames; ++f) {
+                    temporal.settings.camera = orbit(f);
+                    temporal.Render(middle, image);
+                    if (f >= orbitFrames - scoredFrames)
+                        scored[f - (orbitFrames - scoredFrames)] = image;
+                }
+            }, [&]() { temporal.Reset(); }));
+            results.back().rmse = rmse(scored);
+            std::cerr << "  rmse at " << factor << "x step: coarse " << results[results.size() - 2].rmse
+                << ", temporal " << results.back().rmse << "\n";
+        }
+    }
+
+    // Obstacle scene: nearest-surface queries with and without the BVH, a
+    // raymarch drawing the scene in place of the cube, voxelizing it into the
+    // solver's solid mask, and baking it into a distance grid
+    {
+        SdfScene obstacles = GenerateObstacles(options.obstacles, options.seed);
+        const int queryCount = 100000;
+        std::vector<Vector3> points(queryCount);
+        std::mt19937 rng(options.seed);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (Vector3& p : points)
+            p = Vector3(unit(rng) - 0.5f, unit(rng) * 2.0f - 1.0f, unit(rng) - 0.5f);
+
+        double bruteEvaluated = 0.0, bvhEvaluated = 0.0;
+        results.push_back(Measure("sdf_brute", res, options.repeats, queryCount / 1e6, "Mquery/s", [&]() {
+            bruteEvaluated = 0.0;
+            for (const Vector3& p : points) {
+                SdfQuery query;
+                obstacles.DistanceBruteForce(p, &query);
+                bruteEvaluated += query.primitives;
+            }
+        }));
+        results.push_back(Measure("sdf_bvh", res, options.repeats, queryCount / 1e6, "Mquery/s", [&]() {
+            bvhEvaluated = 0.0;
+            for (const Vector3& p : points) {
+                SdfQuery query;
+                obstacles.Distance(p, std::numeric_limits<float>::infinity(), &query);
+                bvhEvaluated += query.primitives;
+            }
+        }));
+        std::cerr << "  primitives per query: brute " << bruteEvaluated / queryCount << ", bvh " << bvhEvaluated / queryCount
+            << "\n";
+
+        CpuRenderer sceneRenderer;
+        sceneRenderer.settings.stepSize = options.stepSize;
+        sceneRenderer.settings.scene = &obstacles;
+        sceneRenderer.Render(middle, image);
+        double sceneSamples = sceneRenderer.LastStats().samples / 1e6;
+        results.push_back(Measure("raymarch_scene", res, options.repeats, sceneSamples, "Msample/s", [&]() {
+            sceneRenderer.Render(middle, image);
+        }));
+        const CpuRenderStats sceneStats = sceneRenderer.LastStats();
+        sceneRenderer.settings.sphereTrace = true;
+        sceneRenderer.Render(middle, image);
+        results.push_back(Measure("raymarch_scene_traced", res, options.repeats, sceneRenderer.LastStats().samples / 1e6,
+            "Msample/s", [&]() { sceneRenderer.Render(middle, image); }));
+        printPerRay("scene", sceneStats, sceneRenderer.LastStats());
+        sceneRenderer.settings.sphereTrace = false;
+
+        const Vector3 boxMin = sceneRenderer.settings.boxMin, boxMax = sceneRenderer.settings.boxMax;
+        const double gridVoxels = static_cast<double>(x) * y * z / 1e6;
+        SmokeSolver solver(x, y, z);
+        results.push_back(Measure("obstacle_voxelize", res, options.repeats, gridVoxels, "Mvoxel/s", [&]() {
+            solver.SetObstacles(&obstacles, boxMin, boxMax);
+        }));
+
+        // Baking the scene into a distance grid at the volume's resolution,
+        // against a full query at every voxel, which is also the reference
+        // its error is measured against
+        const Vector3 cell((boxMax.x - boxMin.x) / x, (boxMax.y - boxMin.y) / y, (boxMax.z - boxMin.z) / z);
+        VoxelGrid<float> exact(x, y, z), baked(x, y, z);
+        results.push_back(Measure("sdf_bake_exact", res, options.repeats, gridVoxels, "Mvoxel/s", [&]() {
+            ParallelFor(z, [&](int k0, int k1) {
+                for (int k = k0; k < k1; ++k)
+                    for (int j = 0; j < y; ++j)
+                        for (int i = 0; i < x; ++i)
+                            exact.At(i, j, k) = obstacles.Distance(Vector3(boxMin.x + (i + 0.5f) * cell.x,
+                                boxMin.y + (j + 0.5f) * cell.y, boxMin.z + (k + 0.5f) * cell.z));
+            });
+        }));
+        SdfBaker baker;
+        results.push_back(Measure("sdf_bake", res, options.repeats, gridVoxels, "Mvoxel/s", [&]() {
+            baker.Bake(obstacles, boxMin, boxMax, baked);
+        }));
+        const float voxel = std::max(cell.x, std::max(cell.y, cell.z));
+        double sumSq = 0.0, maxError = 0.0;
+        for (size_t i = 0; i < baked.Size(); ++i) {
+            double e = std::abs(baked.Data()[i] - exact.Data()[i]) / voxel;
+            sumSq += e * e;
+            maxError = std::max(maxError, e);
+        }
+        results.back().voxelError = std::sqrt(sumSq / baked.Size());
+        std::cerr << "  bake error in voxels: rms " << results.back().voxelError << ", max " << maxError << "; "
+            << baker.LastStats().evaluated << " voxels evaluated, " << baker.LastStats().seeds << " seeds\n";
+
+        sceneRenderer.settings.solidField = &baked;
+        sceneRenderer.Render(middle, image);
+        double bakedSamples = sceneRenderer.LastStats().samples / 1e6;
+        results.push_back(Measure("raymarch_baked", res, options.repeats, bakedSamples, "Msample/s", [&]() {
+            sceneRenderer.Render(middle, image);
+        }));
+        const CpuRenderStats bakedStats = sceneRenderer.LastStats();
+        sceneRenderer.settings.sphereTrace = true;
+        sceneRenderer.Render(middle, image);
+        results.push_back(Measure("raymarch_baked_traced", res, options.repeats, sceneRenderer.LastStats().samples / 1e6,
+            "Msample/s", [&]() { sceneRenderer.Render(middle, image); }));
+        printPerRay("baked", bakedStats, sceneRenderer.LastStats());
+    }
+
+    // Tracer advection through a steady swirl rising up the middle
+    SmokeFields flow(x, y, z);
+    for (int k = 0; k < z; ++k)
+        for (int j = 0; j < y; ++j)
+            for (int i = 0; i < x; ++i) {
+                float dx = i - 0.5f * (x - 1), dz = k - 0.5f * (z - 1);
+                flow.u.At(i, j, k) = -0.2f * dz;
+                flow.v.At(i, j, k) = 2.0f;
+                flow.w.At(i, j, k) = 0.2f * dx;
+            }
+    const VelocityField velocity = VelocityField::Collocated(flow);
+    const int particleSteps = 4;
+    const float particleDt = 0.05f;
+    ParticleSystem particles(options.particles, options.seed);
+    auto seedParticles = [&]() {
+        std::mt19937 rng(options.seed);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        particles.Clear();
+        while (particles.Add(Vector3(unit(rng) * (x - 1), unit(rng) * (y - 1) * 0.5f, unit(rng) * (z - 1))))
+            ;
+    };
+    const double megaParticleSteps = static_cast<double>(options.particles) * particleSteps / 1e6;
+    for (ParticleIntegrator integrator : { ParticleIntegrator::RK2, ParticleIntegrator::RK4 }) {
+        particles.integrator = integrator;
+        const char* stageName = integrator == ParticleIntegrator::RK2 ? "particles_rk2" : "particles_rk4";
+        results.push_back(Measure(stageName, res, options.repeats, megaParticleSteps, "Mparticle-step/s", [&]() {
+            for (int i = 0; i < particleSteps; ++i)
+                particles.Step(velocity, particleDt);
+        }, seedParticles));
+    }
+
+    // Particle-to-grid splatting of the seeded particles
+    seedParticles();
+    ParticleSplatter splatter;
+    VoxelGrid<float> splatGrid(x, y, z);
+    const double megaParticles = static_cast<double>(particles.Count()) / 1e6;
+    for (SplatKernel kernel : { SplatKernel::Trilinear, SplatKernel::CubicBSpline }) {
+        splatter.kernel = kernel;
+        const char* stageName = kernel == SplatKernel::Trilinear ? "splat_trilinear" : "splat_bspline";
+        results.push_back(Measure(stageName, res, options.repeats, megaParticles, "Mparticle/s", [&]() {
+            splatter.Splat(particles.Positions(), particles.Count(), splatGrid);
+        }));
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+void WriteJson(std::ostream& out, const Options& options, const std::vector<Result>& results) {
+    out << "{\n";
+    out << "  \"frames\": " << options.frames << ",\n";
+    out << "  \"particles\": " << options.particles << ",\n";
+    out << "  \"obstacles\": " << options.obstacles << ",\n";
+    out << "  \"repeats\": " << options.repeats << ",\n";
+    out << "  \"seed\": " << options.seed << ",\n";
+    out << "  \"threads\": " << ParallelWorkerCount() << ",\n";
+    out << "  \"image\": [" << options.imageWidth << ", " << options.imageHeight << "],\n";
+    out << "  \"step\": " << options.stepSize << ",\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << (i ? ",\n" : "\n");
+        out << "    { \"name\": \"" << r.name << "\", \"resolution\": [" << r.resolution[0] << ", " << r.resolution[1] << ", "
+            << r.resolution[2] << "], \"best_ms\": " << r.bestMs << ", \"median_ms\": " << r.medianMs
+            << ", \"throughput\": " << r.throughput << ", \"unit\": \"" << r.unit << "\"";
+        if (r.rmse >= 0.0)
+            out << ", \"rmse\": " << r.rmse;
+        if (r.voxelError >= 0.0)
+            out << ", \"voxel_error\": " << r.voxelError;
+        out << " }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+    if (options.help) {
+        PrintUsage();
+        return 0;
+    }
+
+    if (!options.trace.empty()) {
+        Profiler::SetThreadName("Benchmark");
+        Profiler::SetEnabled(true);
+    }
+
+    std::vector<Result> results;
+    for (const auto& res : options.resolutions)
+        RunResolution(options, res, results);
+
+    if (options.out.empty()) {
+        WriteJson(std::cout, options, results);
+    }
+    else {
+        std::ofstream out(options.out);
+        WriteJson(out, options, results);
+        if (!out.good()) {
+            std::cerr << "Could not write " << options.out << "\n";
+            return 1;
+        }
+    }
+
+    if (!options.trace.empty() && !Profiler::WriteChromeTrace(options.trace)) {
+        std::cerr << "Could not write " << options.trace << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "BrickDiff.hpp"
+#include "ParallelFor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+bool DiffBricks(const VoxelGrid<float>& previous, const VoxelGrid<float>& current, BrickMask& dirty, int limit) {
+    std::atomic<int> changedCount = 0;
+    ParallelFor(dirty.BrickCount(), [&](int begin, int end) {
+        for (int b = begin; b < end; ++b) {
+            if (changedCount.load(std::memory_order_relaxed) > limit)
+                return;
+            BrickRange r = dirty.Bounds(b);
+            size_t rowBytes = (r.x1 - r.x0) * sizeof(float);
+            bool changed = false;
+            for (int z = r.z0; z < r.z1 && !changed; ++z)
+                for (int y = r.y0; y < r.y1 && !changed; ++y)
+                    changed = std::memcmp(&previous.At(r.x0, y, z), &current.At(r.x0, y, z), rowBytes) != 0;
+            dirty.Set(b, changed);
+            if (changed)
+                changedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    return changedCount <= limit;
+}
+
+void CoalesceBricks(const BrickMask& dirty, std::vector<BrickRange>& boxes) {
+    boxes.clear();
+
+    const int bx = dirty.BricksX(), by = dirty.BricksY(), bz = dirty.BricksZ();
+    std::vector<uint8_t> open(dirty.BrickCount());
+    for (int b = 0; b < dirty.BrickCount(); ++b)
+        open[b] = dirty.Test(b) ? 1 : 0;
+
+    auto isOpen = [&](int x, int y, int z) { return open[dirty.Index(x, y, z)] != 0; };
+    auto rowOpen = [&](int x0, int x1, int y, int z) {
+        for (int x = x0; x < x1; ++x)
+            if (!isOpen(x, y, z))
+                return false;
+        return true;
+    };
+
+    for (int z = 0; z < bz; ++z)
+        for (int y = 0; y < by; ++y)
+            for (int x = 0; x < bx; ++x) {
+                if (!isOpen(x, y, z))
+                    continue;
+
+                int x1 = x + 1;
+                while (x1 < bx && isOpen(x1, y, z))
+                    ++x1;
+
+                int y1 = y + 1;
+                while (y1 < by && rowOpen(x, x1, y1, z))
+                    ++y1;
+
+                int z1 = z + 1;
+                for (; z1 < bz; ++z1) {
+                    bool planeOpen = true;
+                    for (int yy = y; yy < y1 && planeOpen; ++yy)
+                        planeOpen = rowOpen(x, x1, yy, z1);
+                    if (!planeOpen)
+                        break;
+                }
+
+                for (int zz = z; zz < z1; ++zz)
+                    for (int yy = y; yy < y1; ++yy)
+                        for (int xx = x; xx < x1; ++xx)
+                            open[dirty.Index(xx, yy, zz)] = 0;
+
+                BrickRange lo = dirty.Bounds(dirty.Index(x, y, z));
+                BrickRange hi = dirty.Bounds(dirty.Index(x1 - 1, y1 - 1, z1 - 1));
+                boxes.push_back({ lo.x0, lo.y0, lo.z0, hi.x1, hi.y1, hi.z1 });
+            }
+}
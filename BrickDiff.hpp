@@ -0,0 +1,17 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+#include "BrickMask.hpp"
+#include "VoxelGrid.hpp"
+
+// Flags every brick whose voxels differ between `previous` and `current`.
+// Both grids and the mask must have the same dimensions. Gives up once more
+// than `limit` bricks differ and returns false, leaving the mask incomplete.
+bool DiffBricks(const VoxelGrid<float>& previous, const VoxelGrid<float>& current, BrickMask& dirty,
+    int limit = std::numeric_limits<int>::max());
+
+// Merges flagged bricks into a small set of disjoint voxel-space boxes that
+// together cover exactly the flagged bricks. Greedy: grows runs along x, then
+// stacks equal runs along y, then equal rectangles along z.
+void CoalesceBricks(const BrickMask& dirty, std::vector<BrickRange>& boxes);
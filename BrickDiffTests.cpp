@@ -0,0 +1,152 @@
+#include "BrickDiff.hpp"
+#include "FakeVolume.hpp"
+#include "Tests.hpp"
+
+namespace {
+
+// Counts how many boxes cover each voxel
+std::vector<int> Coverage(const VoxelGrid<float>& grid, const std::vector<BrickRange>& boxes) {
+    std::vector<int> covered(grid.Size(), 0);
+    for (const BrickRange& b : boxes)
+        for (int z = b.z0; z < b.z1; ++z)
+            for (int y = b.y0; y < b.y1; ++y)
+                for (int x = b.x0; x < b.x1; ++x)
+                    covered[x + static_cast<size_t>(grid.Width()) * (y + static_cast<size_t>(grid.Height()) * z)]++;
+    return covered;
+}
+
+// Boxes are disjoint, clipped to the grid and cover exactly the flagged bricks
+bool CoversExactly(const BrickMask& mask, const VoxelGrid<float>& grid, const std::vector<BrickRange>& boxes) {
+    for (const BrickRange& b : boxes)
+        if (b.x0 < 0 || b.y0 < 0 || b.z0 < 0 || b.x1 > grid.Width() || b.y1 > grid.Height() || b.z1 > grid.Depth())
+            return false;
+    std::vector<int> covered = Coverage(grid, boxes);
+    for (int z = 0; z < grid.Depth(); ++z)
+        for (int y = 0; y < grid.Height(); ++y)
+            for (int x = 0; x < grid.Width(); ++x) {
+                int expected = mask.TestVoxel(x, y, z) ? 1 : 0;
+                if (covered[x + static_cast<size_t>(grid.Width()) * (y + static_cast<size_t>(grid.Height()) * z)] != expected)
+                    return false;
+            }
+    return true;
+}
+
+}
+
+TEST(DiffBricksIdenticalFrames) {
+    VoxelGrid<float> a = TestVolume(24, 16, 16, 1), b = a;
+    BrickMask dirty(24, 16, 16);
+    dirty.Fill();
+    CHECK(DiffBricks(a, b, dirty));
+    CHECK(dirty.ActiveCount() == 0);
+}
+
+TEST(DiffBricksSingleVoxel) {
+    VoxelGrid<float> a = TestVolume(24, 16, 16, 1);
+    for (int x : { 0, 7, 8, 23 }) {
+        VoxelGrid<float> b = a;
+        b.At(x, 9, 3) += 1.0f;
+        BrickMask dirty(24, 16, 16);
+        CHECK(DiffBricks(a, b, dirty));
+        CHECK(dirty.ActiveCount() == 1);
+        CHECK(dirty.Test(x / 8, 1, 0));
+    }
+}
+
+TEST(DiffBricksEdgeBricks) {
+    // 20x13x9: the last brick along each axis is partial
+    VoxelGrid<float> a = TestVolume(20, 13, 9, 2);
+    BrickMask dirty(20, 13, 9);
+    CHECK(dirty.BricksX() == 3 && dirty.BricksY() == 2 && dirty.BricksZ() == 2);
+
+    VoxelGrid<float> b = a;
+    b.At(19, 12, 8) = -1.0f;
+    CHECK(DiffBricks(a, b, dirty));
+    CHECK(dirty.ActiveCount() == 1);
+    CHECK(dirty.Test(2, 1, 1));
+
+    b = a;
+    b.At(16, 0, 0) = -1.0f;
+    b.At(0, 8, 0) = -1.0f;
+    b.At(0, 0, 8) = -1.0f;
+    CHECK(DiffBricks(a, b, dirty));
+    CHECK(dirty.ActiveCount() == 3);
+    CHECK(dirty.Test(2, 0, 0) && dirty.Test(0, 1, 0) && dirty.Test(0, 0, 1));
+}
+
+TEST(DiffBricksLimit) {
+    VoxelGrid<float> a = TestVolume(32, 32, 32, 3), b = TestVolume(32, 32, 32, 4);
+    BrickMask dirty(32, 32, 32);
+    CHECK(!DiffBricks(a, b, dirty, 10));
+    CHECK(DiffBricks(a, b, dirty, dirty.BrickCount()));
+    CHECK(dirty.ActiveCount() == dirty.BrickCount());
+}
+
+TEST(CoalesceBricksMergesAlongX) {
+    VoxelGrid<float> grid(40, 16, 16);
+    BrickMask mask(40, 16, 16);
+    for (int x = 1; x < 5; ++x)
+        mask.Set(x, 1, 1);
+    std::vector<BrickRange> boxes;
+    CoalesceBricks(mask, boxes);
+    CHECK(boxes.size() == 1);
+    CHECK(CoversExactly(mask, grid, boxes));
+}
+
+TEST(CoalesceBricksMergesAlongY) {
+    VoxelGrid<float> grid(16, 40, 16);
+    BrickMask mask(16, 40, 16);
+    for (int y = 0; y < 5; ++y)
+        mask.Set(1, y, 0);
+    std::vector<BrickRange> boxes;
+    CoalesceBricks(mask, boxes);
+    CHECK(boxes.size() == 1);
+    CHECK(CoversExactly(mask, grid, boxes));
+}
+
+TEST(CoalesceBricksMergesAlongZ) {
+    VoxelGrid<float> grid(16, 16, 40);
+    BrickMask mask(16, 16, 40);
+    for (int z = 1; z < 4; ++z)
+        for (int y = 0; y < 2; ++y)
+            for (int x = 0; x < 2; ++x)
+                mask.Set(x, y, z);
+    std::vector<BrickRange> boxes;
+    CoalesceBricks(mask, boxes);
+    CHECK(boxes.size() == 1);
+    CHECK(boxes.size() == 1 && boxes[0].Voxels() == 16 * 16 * 24);
+    CHECK(CoversExactly(mask, grid, boxes));
+}
+
+TEST(CoalesceBricksIrregular) {
+    // An L shape and a lone brick stay disjoint and exact
+    VoxelGrid<float> grid(32, 32, 16);
+    BrickMask mask(32, 32, 16);
+    mask.Set(0, 0, 0);
+    mask.Set(1, 0, 0);
+    mask.Set(0, 1, 0);
+    mask.Set(3, 3, 1);
+    std::vector<BrickRange> boxes;
+    CoalesceBricks(mask, boxes);
+    CHECK(boxes.size() == 3);
+    CHECK(CoversExactly(mask, grid, boxes));
+}
+
+TEST(CoalesceBricksPartialBricks) {
+    // Dimensions that are not multiples of 8 clip the last boxes to the grid
+    VoxelGrid<float> grid(21, 10, 11);
+    BrickMask mask(21, 10, 11);
+    mask.Fill();
+    std::vector<BrickRange> boxes;
+    CoalesceBricks(mask, boxes);
+    CHECK(boxes.size() == 1);
+    CHECK(boxes.size() == 1 && boxes[0].x1 == 21 && boxes[0].y1 == 10 && boxes[0].z1 == 11);
+    CHECK(CoversExactly(mask, grid, boxes));
+
+    mask.Clear();
+    mask.Set(2, 1, 1);
+    mask.Set(2, 0, 1);
+    CoalesceBricks(mask, boxes);
+    CHECK(boxes.size() == 1);
+    CHECK(CoversExactly(mask, grid, boxes));
+}
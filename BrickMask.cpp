@@ -0,0 +1,100 @@
+#include "BrickMask.hpp"
+#include "ParallelFor.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+BrickMask::BrickMask(int voxelsX, int voxelsY, int voxelsZ)
+    : voxelsX(voxelsX), voxelsY(voxelsY), voxelsZ(voxelsZ),
+      bricksX((voxelsX + Size - 1) / Size), bricksY((voxelsY + Size - 1) / Size), bricksZ((voxelsZ + Size - 1) / Size),
+      flags(static_cast<size_t>(bricksX) * bricksY * bricksZ, 0) {}
+
+void BrickMask::Clear() {
+    std::fill(flags.begin(), flags.end(), uint8_t(0));
+}
+
+void BrickMask::Fill() {
+    std::fill(flags.begin(), flags.end(), uint8_t(1));
+}
+
+void BrickMask::Mark(const VoxelGrid<float>& field, float threshold) {
+    ParallelFor(BrickCount(), [&](int begin, int end) {
+        for (int b = begin; b < end; ++b) {
+            if (flags[b])
+                continue;
+            BrickRange r = Bounds(b);
+            bool hit = false;
+            for (int z = r.z0; z < r.z1 && !hit; ++z)
+                for (int y = r.y0; y < r.y1 && !hit; ++y) {
+                    const float* row = &field.At(0, y, z);
+                    for (int x = r.x0; x < r.x1; ++x)
+                        hit |= std::fabs(row[x]) > threshold;
+                }
+            if (hit)
+                flags[b] = 1;
+        }
+    });
+}
+
+void BrickMask::MarkBox(int x0, int y0, int z0, int x1, int y1, int z1) {
+    int bx0 = std::max(x0, 0) / Size, bx1 = std::min((std::min(x1, voxelsX) + Size - 1) / Size, bricksX);
+    int by0 = std::max(y0, 0) / Size, by1 = std::min((std::min(y1, voxelsY) + Size - 1) / Size, bricksY);
+    int bz0 = std::max(z0, 0) / Size, bz1 = std::min((std::min(z1, voxelsZ) + Size - 1) / Size, bricksZ);
+    for (int bz = bz0; bz < bz1; ++bz)
+        for (int by = by0; by < by1; ++by)
+            for (int bx = bx0; bx < bx1; ++bx)
+                Set(bx, by, bz);
+}
+
+void BrickMask::Dilate(int radius) {
+    if (radius <= 0)
+        return;
+
+    // Separable max filter, one axis at a time
+    const int dims[3] = { bricksX, bricksY, bricksZ };
+    const int strides[3] = { 1, bricksX, bricksX * bricksY };
+    for (int axis = 0; axis < 3; ++axis) {
+        scratch = flags;
+        for (int bz = 0; bz < bricksZ; ++bz)
+            for (int by = 0; by < bricksY; ++by)
+                for (int bx = 0; bx < bricksX; ++bx) {
+                    int c[3] = { bx, by, bz };
+                    int index = Index(bx, by, bz);
+                    int lo = std::max(c[axis] - radius, 0) - c[axis];
+                    int hi = std::min(c[axis] + radius, dims[axis] - 1) - c[axis];
+                    uint8_t on = 0;
+                    for (int o = lo; o <= hi && !on; ++o)
+                        on = scratch[index + o * strides[axis]];
+                    flags[index] = on;
+                }
+    }
+}
+
+BrickRange BrickMask::Bounds(int index) const {
+    int bx = index % bricksX;
+    int by = (index / bricksX) % bricksY;
+    int bz = index / (bricksX * bricksY);
+    return {
+        bx * Size, by * Size, bz * Size,
+        std::min((bx + 1) * Size, voxelsX), std::min((by + 1) * Size, voxelsY), std::min((bz + 1) * Size, voxelsZ)
+    };
+}
+
+int BrickMask::ActiveCount() const {
+    return static_cast<int>(std::count(flags.begin(), flags.end(), uint8_t(1)));
+}
+
+size_t BrickMask::ActiveVoxels() const {
+    size_t voxels = 0;
+    for (int b = 0; b < BrickCount(); ++b)
+        if (flags[b])
+            voxels += Bounds(b).Voxels();
+    return voxels;
+}
+
+void BrickMask::ActiveList(std::vector<int>& out) const {
+    out.clear();
+    for (int b = 0; b < BrickCount(); ++b)
+        if (flags[b])
+            out.push_back(b);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "VoxelGrid.hpp"
+
+// Voxel-space bounds of a brick, half-open and clipped to the grid.
+struct BrickRange {
+    int x0, y0, z0;
+    int x1, y1, z1;
+
+    size_t Voxels() const { return static_cast<size_t>(x1 - x0) * (y1 - y0) * (z1 - z0); }
+};
+
+// One flag per Size^3 brick of a voxel grid. Used to restrict work to the
+// part of the domain that actually holds smoke.
+class BrickMask {
+public:
+    static constexpr int Size = 8;
+
+    BrickMask(int voxelsX = 0, int voxelsY = 0, int voxelsZ = 0);
+
+    int BricksX() const { return bricksX; }
+    int BricksY() const { return bricksY; }
+    int BricksZ() const { return bricksZ; }
+    int BrickCount() const { return static_cast<int>(flags.size()); }
+
+    int Index(int bx, int by, int bz) const { return bx + bricksX * (by + bricksY * bz); }
+    bool Test(int bx, int by, int bz) const { return flags[Index(bx, by, bz)] != 0; }
+    bool Test(int index) const { return flags[index] != 0; }
+    bool TestVoxel(int x, int y, int z) const { return Test(x / Size, y / Size, z / Size); }
+    void Set(int index, bool on = true) { flags[index] = on ? 1 : 0; }
+    void Set(int bx, int by, int bz, bool on = true) { Set(Index(bx, by, bz), on); }
+
+    void Clear();
+    void Fill();
+
+    // Flags every brick holding a voxel with |value| > threshold.
+    void Mark(const VoxelGrid<float>& field, float threshold);
+    // Flags every brick overlapping the voxel box [x0, x1) x [y0, y1) x [z0, z1).
+    void MarkBox(int x0, int y0, int z0, int x1, int y1, int z1);
+    // Grows the flagged region by `radius` bricks in every direction.
+    void Dilate(int radius);
+
+    BrickRange Bounds(int index) const;
+    int ActiveCount() const;
+    size_t ActiveVoxels() const;
+    void ActiveList(std::vector<int>& out) const;
+
+private:
+    int voxelsX, voxelsY, voxelsZ;
+    int bricksX, bricksY, bricksZ;
+    std::vector<uint8_t> flags;
+    std::vector<uint8_t> scratch;
+};
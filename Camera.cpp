@@ -0,0 +1,109 @@
+#include "Camera.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const float maxPitch = 1.55f; // Just under 90 degrees, so the basis stays defined
+
+}
+
+Camera::Camera() {
+    LookAt(Vector3(2.0f, -1.5f, -2.0f), Vector3(0.0f, 0.0f, 0.0f));
+}
+
+void Camera::HorizontalAxes(Vector3& a, Vector3& b) const {
+    Vector3 up = worldUp.normalized();
+    Vector3 reference = std::abs(up.x) < 0.9f ? Vector3(1.0f, 0.0f, 0.0f) : Vector3(0.0f, 0.0f, 1.0f);
+    a = (reference - up * reference.dot(up)).normalized();
+    b = up.cross(a);
+}
+
+void Camera::LookAt(const Vector3& eye, const Vector3& at) {
+    Vector3 a, b;
+    HorizontalAxes(a, b);
+    Vector3 d = (at - eye).normalized();
+    yaw = std::atan2(d.dot(b), d.dot(a));
+    pitch = std::clamp(std::asin(std::clamp(d.dot(worldUp.normalized()), -1.0f, 1.0f)), -maxPitch, maxPitch);
+    target = at;
+    distance = std::max((at - eye).magnitude(), 1e-3f);
+    position = eye;
+}
+
+void Camera::SetMode(CameraMode m) {
+    if (m == mode)
+        return;
+    if (m == CameraMode::Fly)
+        position = Position();
+    else
+        target = position + Forward() * distance;
+    mode = m;
+}
+
+Vector3 Camera::Forward() const {
+    Vector3 a, b;
+    HorizontalAxes(a, b);
+    return (a * std::cos(yaw) + b * std::sin(yaw)) * std::cos(pitch) + worldUp.normalized() * std::sin(pitch);
+}
+
+Vector3 Camera::Position() const {
+    return mode == CameraMode::Orbit ? target - Forward() * distance : position;
+}
+
+void Camera::Rotate(float dYaw, float dPitch) {
+    yaw = std::remainder(yaw + dYaw, 6.2831853f);
+    pitch = std::clamp(pitch + dPitch, -maxPitch, maxPitch);
+}
+
+void Camera::Zoom(float factor) {
+    if (mode == CameraMode::Orbit)
+        distance = std::clamp(distance * factor, 0.05f, farPlane * 0.5f);
+    else
+        position += Forward() * (distance * (1.0f - factor));
+}
+
+void Camera::Move(float dRight, float dUp, float dForward) {
+    CameraFrame f = Frame(1, 1);
+    Vector3 delta = f.right * dRight + f.up * dUp + f.forward * dForward;
+    // Orbit mode pans the centre, taking the eye along with it
+    if (mode == CameraMode::Orbit)
+        target += delta;
+    else
+        position += delta;
+}
+
+CameraFrame Camera::Frame(int width, int height) const {
+    CameraFrame f;
+    f.position = Position();
+    f.forward = Forward();
+    f.right = worldUp.normalized().cross(f.forward).normalized();
+    f.up = f.forward.cross(f.right);
+    f.tanHalfFovY = std::tan(fovY * 0.5f);
+    f.aspect = static_cast<float>(std::max(width, 1)) / std::max(height, 1);
+
+    // View to world: the basis as columns, then the position
+    const float invView[16] = {
+        f.right.x, f.up.x, f.forward.x, f.position.x,
+        f.right.y, f.up.y, f.forward.y, f.position.y,
+        f.right.z, f.up.z, f.forward.z, f.position.z,
+        0.0f, 0.0f, 0.0f, 1.0f,
+    };
+    // Inverse of the left-handed D3D perspective with depth 0..1
+    const float a = farPlane / (farPlane - nearPlane);
+    const float b = -nearPlane * farPlane / (farPlane - nearPlane);
+    const float invProj[16] = {
+        f.tanHalfFovY * f.aspect, 0.0f, 0.0f, 0.0f,
+        0.0f, f.tanHalfFovY, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f,
+        0.0f, 0.0f, 1.0f / b, -a / b,
+    };
+    for (int r = 0; r < 4; ++r)
+        for (int c = 0; c < 4; ++c) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; ++k)
+                sum += invView[r * 4 + k] * invProj[k * 4 + c];
+            f.invViewProj[r * 4 + c] = sum;
+        }
+    return f;
+}
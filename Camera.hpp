@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Vector3.hpp"
+
+enum class CameraMode {
+    Orbit, // Turns around `target` at `distance`
+    Fly    // Turns in place and moves along its own axes
+};
+
+// Everything a raymarcher needs for one frame, computed once on the CPU.
+// Screen coordinates follow D3D clip space: x right, y up, both -1..1.
+struct CameraFrame {
+    Vector3 position;
+    Vector3 forward, right, up; // Orthonormal
+    float tanHalfFovY = 0.5f;
+    float aspect = 1.0f;
+    // Clip space to world space, row-major and applied to column vectors.
+    // A clip point (x, y, 1, 1) unprojects onto the far plane along the ray.
+    float invViewProj[16] = {};
+
+    // Unnormalized direction of the ray through a clip-space point
+    Vector3 RayDirection(float clipX, float clipY) const {
+        return forward + right * (clipX * tanHalfFovY * aspect) + up * (clipY * tanHalfFovY);
+    }
+};
+
+// Orbit or fly camera. Orientation is a yaw around `worldUp` and a pitch
+// towards it, so the horizon never rolls.
+class Camera {
+public:
+    CameraMode mode = CameraMode::Orbit;
+    // The original shader drew world -y at the top of the screen, which the
+    // default keeps so existing scenes look the same
+    Vector3 worldUp = Vector3(0.0f, -1.0f, 0.0f);
+    float fovY = 0.9273f; // 2 atan(0.5), the original shader's view
+    float nearPlane = 0.01f;
+    float farPlane = 100.0f;
+
+    Vector3 target;         // Orbit centre
+    float distance = 1.0f;  // Orbit radius
+    Vector3 position;       // Fly position; derived from the orbit in Orbit mode
+    float yaw = 0.0f, pitch = 0.0f; // Radians
+
+    // The view of the original shader: (2, -1.5, -2) looking at the origin.
+    Camera();
+
+    void LookAt(const Vector3& eye, const Vector3& at);
+    // Switches mode without moving the view.
+    void SetMode(CameraMode m);
+
+    Vector3 Position() const;
+    Vector3 Forward() const;
+
+    // Mouse look, in radians. Pitch stops just short of straight up or down.
+    void Rotate(float dYaw, float dPitch);
+    // Scales the orbit distance; in Fly mode moves forward by the same fraction of it.
+    void Zoom(float factor);
+    // Fly mode: moves along the camera's right, up and forward axes.
+    void Move(float dRight, float dUp, float dForward);
+
+    CameraFrame Frame(int width, int height) const;
+
+private:
+    // Horizontal axes perpendicular to worldUp, yaw 0 looking along the first
+    void HorizontalAxes(Vector3& a, Vector3& b) const;
+};
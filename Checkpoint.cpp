@@ -0,0 +1,91 @@
+#include "Checkpoint.hpp"
+#include "SimFile.hpp"
+#include "SmokeSolver.hpp"
+
+#include <filesystem>
+
+CheckpointWriter::~CheckpointWriter() {
+    Stop();
+}
+
+void CheckpointWriter::Start(const std::string& checkpointPath, int x, int y, int z) {
+    Stop();
+
+    path = checkpointPath;
+    width = x;
+    height = y;
+    depth = z;
+    quit = false;
+    lastWritten = -1;
+    worker = std::thread(&CheckpointWriter::Run, this);
+}
+
+void CheckpointWriter::Stop() {
+    if (!worker.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void CheckpointWriter::Submit(const SmokeSolver& solver, int step) {
+    if (!worker.joinable())
+        return;
+
+    // Serialize outside the lock; only the buffer swap is shared
+    solver.SaveCheckpoint(snapshot);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.swap(snapshot);
+        pendingStep = step;
+    }
+    wake.notify_one();
+}
+
+void CheckpointWriter::Run() {
+    std::vector<char> payload;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this]() { return quit || pendingStep >= 0; });
+        if (pendingStep < 0)
+            return; // Quit with nothing left to write
+
+        payload.swap(pending);
+        int step = pendingStep;
+        pendingStep = -1;
+        lock.unlock();
+
+        std::string temp = path + ".tmp";
+        SimFileWriter writer;
+        bool ok = writer.Open(temp, width, height, depth) &&
+            writer.WriteChunk(SimFile::CheckpointTag, payload.data(), payload.size());
+        ok = writer.Close() && ok;
+
+        std::error_code ec;
+        if (ok)
+            std::filesystem::rename(temp, path, ec);
+        if (ok && !ec)
+            lastWritten = step;
+
+        lock.lock();
+    }
+}
+
+bool LoadCheckpoint(const std::string& path, SmokeSolver& solver) {
+    SimFileReader reader;
+    if (!reader.Open(path))
+        return false;
+
+    const std::vector<SimChunk>& chunks = reader.Chunks();
+    for (auto it = chunks.rbegin(); it != chunks.rend(); ++it) {
+        if (!it->Is(SimFile::CheckpointTag))
+            continue;
+        std::vector<char> payload;
+        return reader.ReadChunk(*it, payload) && solver.LoadCheckpoint(payload);
+    }
+    return false;
+}
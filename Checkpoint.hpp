@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class SmokeSolver;
+
+// Writes solver checkpoints on a background thread so stepping never waits on
+// disk. Each checkpoint replaces the file at `path` (written to a temporary
+// file and renamed), so the file always holds the latest complete one. If a
+// new checkpoint arrives while the previous is still queued, the older one is
+// dropped.
+class CheckpointWriter {
+public:
+    ~CheckpointWriter();
+
+    void Start(const std::string& path, int width, int height, int depth);
+    // Blocks until any queued checkpoint has been written.
+    void Stop();
+
+    // Snapshots the solver and queues it for writing.
+    void Submit(const SmokeSolver& solver, int step);
+
+    int LastWrittenStep() const { return lastWritten; }
+
+private:
+    void Run();
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool quit = false;
+
+    std::string path;
+    int width = 0, height = 0, depth = 0;
+
+    std::vector<char> snapshot;   // Filled by the stepping thread
+    std::vector<char> pending;    // Handed to the writer
+    int pendingStep = -1;
+    std::atomic<int> lastWritten = -1;
+};
+
+// Restores the checkpoint stored at `path`. Returns false if there is none or
+// it does not match the solver.
+bool LoadCheckpoint(const std::string& path, SmokeSolver& solver);
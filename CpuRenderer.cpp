@@ -0,0 +1,328 @@
+#include "CpuRenderer.hpp"
+#include "ParallelFor.hpp"
+#include "Profiler.hpp"
+#include "Vector3Array.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+float CubeSDF(const Vector3& p, const Vector3& center, const Vector3& size) {
+    Vector3 d = p - center;
+    d = Vector3(std::abs(d.x) - size.x, std::abs(d.y) - size.y, std::abs(d.z) - size.z);
+    Vector3 outside(std::max(d.x, 0.0f), std::max(d.y, 0.0f), std::max(d.z, 0.0f));
+    return outside.magnitude() + std::min(std::max(d.x, std::max(d.y, d.z)), 0.0f);
+}
+
+// Unit gradient of CubeSDF from four lookups at the corners of a small tetrahedron
+Vector3 CubeNormal(const Vector3& p, const Vector3& center, const Vector3& size) {
+    const float h = 1e-4f;
+    const Vector3 a(1.0f, -1.0f, -1.0f), b(-1.0f, -1.0f, 1.0f), c(-1.0f, 1.0f, -1.0f), d(1.0f, 1.0f, 1.0f);
+    Vector3 n = a * CubeSDF(p + a * h, center, size) + b * CubeSDF(p + b * h, center, size)
+        + c * CubeSDF(p + c * h, center, size) + d * CubeSDF(p + d * h, center, size);
+    return n.normalized();
+}
+
+bool IntersectBoundingBox(const Vector3& origin, const Vector3& dir, const Vector3& boxMin, const Vector3& boxMax, float& tNear, float& tFar) {
+    float t1x = (boxMin.x - origin.x) / dir.x, t2x = (boxMax.x - origin.x) / dir.x;
+    float t1y = (boxMin.y - origin.y) / dir.y, t2y = (boxMax.y - origin.y) / dir.y;
+    float t1z = (boxMin.z - origin.z) / dir.z, t2z = (boxMax.z - origin.z) / dir.z;
+    tNear = std::max(std::max(std::min(t1x, t2x), std::min(t1y, t2y)), std::min(t1z, t2z));
+    tFar = std::min(std::min(std::max(t1x, t2x), std::max(t1y, t2y)), std::max(t1z, t2z));
+    return tNear <= tFar && tFar >= 0.0f;
+}
+
+// SampleLevel with a linear clamp sampler: texel centres sit at (i + 0.5) / n
+float SampleTexture(const VoxelGrid<float>& density, const Vector3& uvw) {
+    return density.Sample(uvw.x * density.Width() - 0.5f, uvw.y * density.Height() - 0.5f, uvw.z * density.Depth() - 0.5f);
+}
+
+// Gradient of a distance grid spanning the volume box, by central differences a voxel apart
+Vector3 FieldNormal(const VoxelGrid<float>& field, const Vector3& uvw, const Vector3& extent) {
+    const float du = 1.0f / field.Width(), dv = 1.0f / field.Height(), dw = 1.0f / field.Depth();
+    Vector3 n((SampleTexture(field, uvw + Vector3(du, 0.0f, 0.0f)) - SampleTexture(field, uvw - Vector3(du, 0.0f, 0.0f))) / (du * extent.x),
+        (SampleTexture(field, uvw + Vector3(0.0f, dv, 0.0f)) - SampleTexture(field, uvw - Vector3(0.0f, dv, 0.0f))) / (dv * extent.y),
+        (SampleTexture(field, uvw + Vector3(0.0f, 0.0f, dw)) - SampleTexture(field, uvw - Vector3(0.0f, 0.0f, dw))) / (dw * extent.z));
+    return n.normalized();
+}
+
+float Saturate(float v) {
+    return std::clamp(v, 0.0f, 1.0f);
+}
+
+// Interleaved gradient noise, shifted by the golden ratio each frame so
+// every pixel cycles through well spread offsets over time
+float JitterOffset(int x, int y, int frame) {
+    float noise = 52.9829189f * (0.06711056f * x + 0.00583715f * y);
+    noise -= std::floor(noise);
+    float offset = noise + 0.618034f * (frame % 1024);
+    return offset - std::floor(offset);
+}
+
+}
+
+void CpuImage::Resize(int w, int h) {
+    width = w;
+    height = h;
+    rgba.assign(static_cast<size_t>(w) * h * 4, 0.0f);
+    depth.assign(static_cast<size_t>(w) * h, 0.0f);
+}
+
+void CpuRenderer::Render(const VoxelGrid<float>& density, CpuImage& image) {
+    PROFILE_SCOPE("CpuRenderer::Render");
+    auto start = std::chrono::steady_clock::now();
+
+    const CpuRenderSettings s = settings;
+    const CameraFrame view = s.camera.Frame(image.width, image.height);
+    const Vector3 cameraPos = view.position;
+
+    const Vector3 extent = s.boxMax - s.boxMin;
+    const Vector3 background(0.1f, 0.1f, 0.1f);
+    const Vector3 cubePosition(0.0f, -0.75f, 0.0f);
+    const Vector3 cubeSize(0.2f, 0.2f, 0.2f);
+    const Vector3 lightPosition(1.0f, -2.0f, -0.3f);
+    const Vector3 cubeColor(0.6f, 0.6f, 0.6f);
+    const Vector3 smokeTint(0.6f, 0.4f, 0.2f);
+    const float densityThreshold = 0.0f; // The shader's 1e-50 underflows to zero
+    const float minTransmittance = 0.002f; // Transfer modes stop once the ray is this opaque
+    const TransferFunction* tf = s.transfer;
+    const SmokeShading shading = tf ? s.shading : SmokeShading::Classic;
+    const float hitDistance = s.hitDistance > 0.0f ? s.hitDistance : s.stepSize;
+    const float emptyDepth = s.camera.farPlane;
+    const SdfScene* scene = s.scene && !s.scene->Empty() ? s.scene : nullptr;
+    const VoxelGrid<float>* field = s.solidField;
+    // The trilinear field is only good to about a voxel, and creeps towards
+    // zero near grazing surfaces; tracing it finer than half a voxel spends
+    // steps without placing the hit any better
+    const float traceEpsilon = field ? std::max(s.traceEpsilon, 0.5f * std::min(extent.x / field->Width(),
+        std::min(extent.y / field->Height(), extent.z / field->Depth()))) : s.traceEpsilon;
+    // Scene queries look this far ahead so clear stretches of ray skip them
+    const float lookahead = std::max(hitDistance, s.stepSize) * 32.0f;
+
+    auto toTexture = [&](const Vector3& p) {
+        return Vector3((p.x - s.boxMin.x) / extent.x, (p.y - s.boxMin.y) / extent.y, (p.z - s.boxMin.z) / extent.z);
+    };
+
+    std::atomic<uint64_t> samples = 0, solidSteps = 0;
+
+    ParallelFor(image.height, [&](int y0, int y1) {
+        uint64_t localSamples = 0, localSolidSteps = 0;
+        Vector3Array rayDirs(image.width);
+        for (int py = y0; py < y1; ++py) {
+            // Set up the whole row of rays at once, through pixel centres in
+            // clip space
+            const float clipY = 1.0f - 2.0f * (py + 0.5f) / image.height;
+            const Vector3 rowBase = view.RayDirection(0.0f, clipY);
+            const Vector3 rightStep = view.right * (view.tanHalfFovY * view.aspect);
+            for (int px = 0; px < image.width; ++px) {
+                float clipX = 2.0f * (px + 0.5f) / image.width - 1.0f;
+                rayDirs.x[px] = rowBase.x + rightStep.x * clipX;
+                rayDirs.y[px] = rowBase.y + rightStep.y * clipX;
+                rayDirs.z[px] = rowBase.z + rightStep.z * clipX;
+            }
+            Normalize(rayDirs);
+
+            for (int px = 0; px < image.width; ++px) {
+                float* out = image.Pixel(px, py);
+                float& outDepth = image.depth[static_cast<size_t>(py) * image.width + px];
+                const Vector3 rayDir = rayDirs.Get(px);
+
+                float tNear, tFar;
+                if (!IntersectBoundingBox(cameraPos, rayDir, s.boxMin, s.boxMax, tNear, tFar)) {
+                    out[0] = background.x;
+                    out[1] = background.y;
+                    out[2] = background.z;
+                    out[3] = 1.0f;
+                    outDepth = emptyDepth;
+                    continue;
+                }
+
+                const float offset = s.jitterFrame >= 0 ? JitterOffset(px, py, s.jitterFrame) : s.stepOffset;
+                const float tStart = tNear + offset * s.stepSize;
+                Vector3 currentPos = cameraPos + rayDir * tStart;
+                float sumDensity = 0.0f;
+                bool hitCube = false;
+                Vector3 boxColor;
+
+                // Emission-absorption state of the transfer function modes
+                Vector3 radiance;
+                float transmittance = 1.0f;
+                float front = 0.0f;
+
+                // Opacity-weighted depth
+                float depthSum = 0.0f, depthWeight = 0.0f;
+
+                // Lit solid surface at t, seen through whatever the smoke leaves
+                auto shadeSurface = [&](const Vector3& position, const Vector3& normal, const Vector3& surfaceColor, float t) {
+                    Vector3 lightDir = (lightPosition - position).normalized();
+                    Vector3 diffuse = surfaceColor * std::max(normal.dot(lightDir), 0.0f);
+                    boxColor = Vector3(0.1f, 0.1f, 0.1f) + diffuse;
+                    hitCube = true;
+                    float visible = shading == SmokeShading::Classic ? std::max(1.0f - sumDensity, 0.0f) : transmittance;
+                    depthSum += visible * t;
+                    depthWeight += visible;
+                };
+
+                // Sphere tracing: every step advances by the distance to the
+                // nearest solid, so the smoke below need only be marched up
+                // to the surface and never tests the solids itself
+                float tEnd = tFar;
+                bool traced = false;
+                Vector3 tracedNormal, tracedColor;
+                if (s.drawCube && s.sphereTrace) {
+                    float t = tNear;
+                    for (int i = 0; i < s.maxTraceSteps && t < tFar; ++i) {
+                        const Vector3 p = cameraPos + rayDir * t;
+                        SdfQuery query;
+                        float distance;
+                        if (field)
+                            distance = SampleTexture(*field, toTexture(p));
+                        else if (scene)
+                            distance = scene->Distance(p, lookahead, &query);
+                        else
+                            distance = CubeSDF(p, cubePosition, cubeSize);
+                        localSolidSteps++;
+                        if (distance <= traceEpsilon) {
+                            // The remaining distance still places the surface
+                            // better than stopping short of it
+                            traced = true;
+                            tEnd = std::min(t + std::max(distance, 0.0f), tFar);
+                            if (field) {
+                                tracedNormal = FieldNormal(*field, toTexture(cameraPos + rayDir * tEnd), extent);
+                                tracedColor = cubeColor;
+                            }
+                            else if (scene) {
+                                tracedNormal = scene->Normal(p);
+                                tracedColor = scene->objects[query.object].color;
+                            }
+                            else {
+                                tracedNormal = CubeNormal(p, cubePosition, cubeSize);
+                                tracedColor = cubeColor;
+                            }
+                            break;
+                        }
+                        t += distance;
+                    }
+                }
+                const bool testSolids = s.drawCube && !s.sphereTrace;
+
+                // Distance along the ray known to be clear of the scene's or field's solids
+                float solidFree = tStart;
+
+                for (float t = tStart; t < tEnd; t += s.stepSize) {
+                    Vector3 texCoord = toTexture(currentPos);
+                    float d = SampleTexture(density, texCoord);
+                    localSamples++;
+                    const float before = transmittance;
+                    if (shading == SmokeShading::Classic) {
+                        if (d > densityThreshold) {
+                            sumDensity += d * s.stepSize;
+                            depthSum += d * s.stepSize * t;
+                            depthWeight += d * s.stepSize;
+                        }
+                    }
+                    else if (shading == SmokeShading::Transfer) {
+                        float rgbe[4];
+                        tf->Evaluate(d, rgbe);
+                        float alpha = 1.0f - std::exp(-rgbe[3] * s.stepSize);
+                        radiance += Vector3(rgbe[0], rgbe[1], rgbe[2]) * (transmittance * alpha);
+                        transmittance *= 1.0f - alpha;
+                    }
+                    else {
+                        // Each sample closes the segment from the previous one
+                        if (t > tStart) {
+                            float rgba[4];
+                            tf->Segment(front, d, s.stepSize, rgba);
+                            radiance += Vector3(rgba[0], rgba[1], rgba[2]) * transmittance;
+                            transmittance *= 1.0f - rgba[3];
+                        }
+                        front = d;
+                    }
+                    if (shading != SmokeShading::Classic) {
+                        depthSum += (before - transmittance) * t;
+                        depthWeight += before - transmittance;
+                    }
+
+                    bool hit = false;
+                    Vector3 normal, surfaceColor;
+                    if (testSolids && field) {
+                        if (t >= solidFree) {
+                            float distance = SampleTexture(*field, texCoord);
+                            localSolidSteps++;
+                            if (distance <= hitDistance) {
+                                hit = true;
+                                normal = FieldNormal(*field, texCoord, extent);
+                                surfaceColor = cubeColor;
+                            }
+                            else {
+                                solidFree = t + distance - hitDistance;
+                            }
+                        }
+                    }
+                    else if (testSolids && scene) {
+                        if (t >= solidFree) {
+                            SdfQuery query;
+                            float distance = scene->Distance(currentPos, lookahead, &query);
+                            localSolidSteps++;
+                            if (distance <= hitDistance) {
+                                hit = true;
+                                normal = scene->Normal(currentPos);
+                                surfaceColor = scene->objects[query.object].color;
+                            }
+                            else {
+                                // No sample before this point can come within hitDistance of a surface
+                                solidFree = t + distance - hitDistance;
+                            }
+                        }
+                    }
+                    else if (testSolids) {
+                        localSolidSteps++;
+                        if (CubeSDF(currentPos, cubePosition, cubeSize) <= hitDistance) {
+                            hit = true;
+                            normal = (currentPos - cubePosition).normalized();
+                            surfaceColor = cubeColor;
+                        }
+                    }
+                    if (hit) {
+                        shadeSurface(currentPos, normal, surfaceColor, t);
+                        break;
+                    }
+                    if (transmittance < minTransmittance)
+                        break;
+
+                    currentPos += rayDir * s.stepSize;
+                }
+                if (traced)
+                    shadeSurface(cameraPos + rayDir * tEnd, tracedNormal, tracedColor, tEnd);
+                outDepth = depthWeight > 1e-4f ? depthSum / depthWeight : emptyDepth;
+
+                if (shading != SmokeShading::Classic) {
+                    // Smoke in front of the cube or the background
+                    Vector3 color = radiance + (hitCube ? boxColor : background) * transmittance;
+                    out[0] = color.x;
+                    out[1] = color.y;
+                    out[2] = color.z;
+                    out[3] = 1.0f - transmittance;
+                    continue;
+                }
+
+                float opacity = Saturate(sumDensity);
+                Vector3 smokeColor = smokeTint * opacity + background;
+                out[0] = smokeColor.x + (hitCube ? boxColor.x : 0.0f);
+                out[1] = smokeColor.y + (hitCube ? boxColor.y : 0.0f);
+                out[2] = smokeColor.z + (hitCube ? boxColor.z : 0.0f);
+                out[3] = opacity + (hitCube ? 1.0f : 0.0f);
+            }
+        }
+        samples += localSamples;
+        solidSteps += localSolidSteps;
+    });
+
+    stats.rays = static_cast<uint64_t>(image.width) * image.height;
+    stats.samples = samples;
+    stats.solidSteps = solidSteps;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
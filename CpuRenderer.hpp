@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Camera.hpp"
+#include "SdfScene.hpp"
+#include "TransferFunction.hpp"
+#include "Vector3.hpp"
+#include "VoxelGrid.hpp"
+
+// RGBA float image, rows top to bottom.
+struct CpuImage {
+    int width = 0, height = 0;
+    std::vector<float> rgba;
+    // Distance along each pixel's ray that best represents what it shows:
+    // the opacity-weighted depth of the smoke and cube, or the camera's far
+    // plane where the ray only sees background. Used for reprojection.
+    std::vector<float> depth;
+
+    void Resize(int w, int h);
+    float* Pixel(int x, int y) { return &rgba[(static_cast<size_t>(y) * width + x) * 4]; }
+    const float* Pixel(int x, int y) const { return &rgba[(static_cast<size_t>(y) * width + x) * 4]; }
+};
+
+// How smoke density becomes colour; matches the SHADING variants of Shader.hlsl.
+enum class SmokeShading {
+    Classic,      // Fixed tint scaled by the saturated density integral
+    Transfer,     // Emission-absorption through the transfer function's 1D table
+    PreIntegrated // Same, one pre-integrated lookup per segment between samples
+};
+
+// Scene constants of the pixel shader in Shader.hlsl.
+struct CpuRenderSettings {
+    Camera camera;
+    Vector3 boxMin = Vector3(-0.5f, -1.0f, -0.5f);
+    Vector3 boxMax = Vector3(0.5f, 1.0f, 0.5f);
+    float stepSize = 0.001f;
+    float stepOffset = 0.0f; // Fraction of a step to skip past the box entry, for jittered passes
+    int jitterFrame = -1;    // If >= 0, per-pixel start offsets for this frame replace stepOffset
+    bool drawCube = true;     // Solids: the built-in cube, or `scene` or `solidField` if set
+    float hitDistance = 0.0f; // Cube surface tolerance; 0 uses stepSize like the shader
+    // Solids are sphere-traced to their surface before the smoke is marched,
+    // which then stops at the hit, instead of being tested at every sample.
+    // Matches the SOLIDS 1 variants of Shader.hlsl.
+    bool sphereTrace = false;
+    float traceEpsilon = 1e-4f; // Sphere-tracing hit tolerance; at least half a voxel for solidField
+    int maxTraceSteps = 128;    // Rays still short of a surface after this many steps miss
+    const SdfScene* scene = nullptr; // Built; drawn instead of the cube, with gradient normals
+    // Baked SdfBaker distances over boxMin..boxMax, drawn instead of the cube
+    // or scene. One lookup per test, accurate to about a voxel.
+    const VoxelGrid<float>* solidField = nullptr;
+    SmokeShading shading = SmokeShading::Classic;
+    const TransferFunction* transfer = nullptr; // Baked; required unless Classic
+};
+
+struct CpuRenderStats {
+    double seconds = 0.0;
+    uint64_t rays = 0;
+    uint64_t samples = 0;    // Density lookups
+    uint64_t solidSteps = 0; // Solid distance evaluations, per sample or per sphere-tracing step
+};
+
+// CPU port of the smoke raymarcher in Shader.hlsl, for headless benchmarks
+// and reference images. Rows are split across ParallelFor workers.
+class CpuRenderer {
+public:
+    CpuRenderSettings settings;
+
+    void Render(const VoxelGrid<float>& density, CpuImage& image);
+
+    const CpuRenderStats& LastStats() const { return stats; }
+
+private:
+    CpuRenderStats stats;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "VolumeRing.hpp"
+#include "VolumeUpload.hpp"
+
+// IVolumeUploadTarget in plain memory, for tests. Map hands out a staging
+// buffer with padded row and depth pitches, like a driver might, and Unmap
+// copies it into `contents`; boxes are written into `contents` directly.
+class FakeVolumeTarget : public IVolumeUploadTarget {
+public:
+    FakeVolumeTarget(int x, int y, int z, bool boxes = true, size_t rowPadding = 0, size_t slicePadding = 0)
+        : contents(x, y, z), boxes(boxes),
+          rowPitch(x * sizeof(float) + rowPadding), depthPitch(rowPitch * y + slicePadding),
+          staging(depthPitch * z) {}
+
+    VoxelGrid<float> contents;
+    bool boxes;
+    size_t rowPitch, depthPitch;
+    std::vector<char> staging;
+
+    int maps = 0;
+    int boxesWritten = 0;
+    size_t voxelsWritten = 0;
+    std::function<void()> onWrite; // Called before every Map and UpdateBox
+
+    int Width() const override { return contents.Width(); }
+    int Height() const override { return contents.Height(); }
+    int Depth() const override { return contents.Depth(); }
+
+    bool Map(MappedVolume& mapped) override {
+        if (onWrite)
+            onWrite();
+        maps++;
+        mapped.data = staging.data();
+        mapped.rowPitch = rowPitch;
+        mapped.depthPitch = depthPitch;
+        return true;
+    }
+
+    void Unmap() override {
+        for (int z = 0; z < Depth(); ++z)
+            for (int y = 0; y < Height(); ++y)
+                std::memcpy(&contents.At(0, y, z), staging.data() + z * depthPitch + y * rowPitch, Width() * sizeof(float));
+        voxelsWritten += contents.Size();
+    }
+
+    bool SupportsBoxes() const override { return boxes; }
+
+    void UpdateBox(const BrickRange& box, const float* src, size_t srcRowPitch, size_t srcDepthPitch) override {
+        if (onWrite)
+            onWrite();
+        const char* base = reinterpret_cast<const char*>(src);
+        for (int z = box.z0; z < box.z1; ++z)
+            for (int y = box.y0; y < box.y1; ++y)
+                std::memcpy(&contents.At(box.x0, y, z), base + (z - box.z0) * srcDepthPitch + (y - box.y0) * srcRowPitch,
+                    (box.x1 - box.x0) * sizeof(float));
+        boxesWritten++;
+        voxelsWritten += box.Voxels();
+    }
+};
+
+// IVolumeDevice with a simulated GPU that finishes each fenced draw a fixed
+// number of Ticks (display frames) after it was issued, answering Idle like
+// an event query would. Writes into a slot the GPU may still be reading are
+// counted rather than stalling.
+class FakeVolumeDevice : public IVolumeDevice {
+public:
+    FakeVolumeDevice(int slots, int latency, int x, int y, int z, bool boxes = true)
+        : latency(latency), busyUntil(slots, 0) {
+        for (int i = 0; i < slots; ++i) {
+            targets.push_back(std::make_unique<FakeVolumeTarget>(x, y, z, boxes));
+            targets.back()->onWrite = [this, i] {
+                if (InFlight(i))
+                    inFlightWrites++;
+            };
+        }
+    }
+
+    std::vector<std::unique_ptr<FakeVolumeTarget>> targets;
+    int latency;
+    uint64_t now = 0;
+    std::vector<uint64_t> busyUntil;
+    int bound = -1;
+    int inFlightWrites = 0;
+
+    void Tick() { now++; }
+    bool InFlight(int slot) const { return now < busyUntil[slot]; }
+
+    int SlotCount() const override { return static_cast<int>(targets.size()); }
+    IVolumeUploadTarget& Slot(int slot) override { return *targets[slot]; }
+    void Bind(int slot) override { bound = slot; }
+    void Fence(int slot) override { busyUntil[slot] = std::max(busyUntil[slot], now + latency); }
+    bool Idle(int slot) override { return !InFlight(slot); }
+};
+
+// Deterministic test volume whose values depend on `seed`.
+inline VoxelGrid<float> TestVolume(int x, int y, int z, int seed) {
+    VoxelGrid<float> grid(x, y, z);
+    for (size_t i = 0; i < grid.Size(); ++i)
+        grid.Data()[i] = static_cast<float>((i * 2654435761u + seed * 40503u) % 1000) * 0.001f;
+    return grid;
+}
+
+inline bool SameVoxels(const VoxelGrid<float>& a, const VoxelGrid<float>& b) {
+    return a.Size() == b.Size() && std::memcmp(a.Data(), b.Data(), a.Size() * sizeof(float)) == 0;
+}
@@ -0,0 +1,44 @@
+#include "FrameBlend.hpp"
+#include "ParallelFor.hpp"
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FRAME_BLEND_SSE2 1
+#endif
+
+namespace {
+
+// Floats per ParallelFor item; large enough to amortise the dispatch
+const int blockFloats = 16384;
+
+void BlendRange(const float* a, const float* b, float t, float* out, size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef FRAME_BLEND_SSE2
+    const __m128 vt = _mm_set1_ps(t);
+    for (; i + 8 <= end; i += 8) {
+        __m128 a0 = _mm_loadu_ps(a + i);
+        __m128 a1 = _mm_loadu_ps(a + i + 4);
+        __m128 d0 = _mm_sub_ps(_mm_loadu_ps(b + i), a0);
+        __m128 d1 = _mm_sub_ps(_mm_loadu_ps(b + i + 4), a1);
+        _mm_storeu_ps(out + i, _mm_add_ps(a0, _mm_mul_ps(d0, vt)));
+        _mm_storeu_ps(out + i + 4, _mm_add_ps(a1, _mm_mul_ps(d1, vt)));
+    }
+#endif
+    for (; i < end; ++i)
+        out[i] = a[i] + (b[i] - a[i]) * t;
+}
+
+}
+
+void BlendFrames(const VoxelGrid<float>& a, const VoxelGrid<float>& b, float t, VoxelGrid<float>& out) {
+    const size_t count = a.Size();
+    const int blocks = static_cast<int>((count + blockFloats - 1) / blockFloats);
+
+    ParallelFor(blocks, [&](int first, int last) {
+        size_t begin = static_cast<size_t>(first) * blockFloats;
+        size_t end = std::min(count, static_cast<size_t>(last) * blockFloats);
+        BlendRange(a.Data(), b.Data(), t, out.Data(), begin, end);
+    });
+}
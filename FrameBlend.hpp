@@ -0,0 +1,8 @@
+#pragma once
+
+#include "VoxelGrid.hpp"
+
+// out = a + (b - a) * t, voxel by voxel. All three grids must have the same
+// dimensions; `out` may alias neither input. Vectorized and split across
+// ParallelFor workers, and safe to call from any thread.
+void BlendFrames(const VoxelGrid<float>& a, const VoxelGrid<float>& b, float t, VoxelGrid<float>& out);
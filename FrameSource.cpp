@@ -0,0 +1,31 @@
+#include "FrameSource.hpp"
+
+#include <chrono>
+
+bool StreamingFrameSource::Open(const std::string& path) {
+    for (Entry& e : cache)
+        e.frame = -1;
+    if (!reader.Open(path))
+        return false;
+
+    for (Entry& e : cache)
+        e.grid = VoxelGrid<float>(reader.Width(), reader.Height(), reader.Depth());
+    return true;
+}
+
+const VoxelGrid<float>* StreamingFrameSource::Frame(int n) {
+    // Two entries, least recently used one replaced
+    for (int i = 0; i < 2; ++i)
+        if (cache[i].frame == n) {
+            next = 1 - i;
+            return &cache[i].grid;
+        }
+
+    Entry& e = cache[next];
+    next = 1 - next;
+
+    auto start = std::chrono::steady_clock::now();
+    e.frame = reader.ReadFrame(n, e.grid) ? n : -1;
+    lastReadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return e.frame == n ? &e.grid : nullptr;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "SimFile.hpp"
+#include "VoxelGrid.hpp"
+
+// Where playback frames come from. Only used from the simulation thread.
+class IFrameSource {
+public:
+    virtual ~IFrameSource() = default;
+
+    virtual int FrameCount() const = 0;
+    virtual int Width() const = 0;
+    virtual int Height() const = 0;
+    virtual int Depth() const = 0;
+
+    // Frame `n`, or null if it could not be read. The pointer stays valid
+    // until two more frames have been requested, so a pair can be blended.
+    virtual const VoxelGrid<float>* Frame(int n) = 0;
+
+    // True if every frame stays valid for the source's lifetime and can be
+    // handed to the renderer without a copy.
+    virtual bool Resident() const = 0;
+};
+
+// Frames already loaded into memory.
+class MemoryFrameSource : public IFrameSource {
+public:
+    // `frames` must outlive the source and stay unchanged.
+    explicit MemoryFrameSource(const std::vector<VoxelGrid<float>>* frames) : frames(frames) {}
+
+    int FrameCount() const override { return static_cast<int>(frames->size()); }
+    int Width() const override { return frames->empty() ? 0 : frames->front().Width(); }
+    int Height() const override { return frames->empty() ? 0 : frames->front().Height(); }
+    int Depth() const override { return frames->empty() ? 0 : frames->front().Depth(); }
+
+    const VoxelGrid<float>* Frame(int n) override { return &(*frames)[n]; }
+    bool Resident() const override { return true; }
+
+private:
+    const std::vector<VoxelGrid<float>>* frames;
+};
+
+// Frames read on demand from a simulation container, for sequences too big
+// to hold in memory. With the container's index a frame costs one read.
+class StreamingFrameSource : public IFrameSource {
+public:
+    bool Open(const std::string& path);
+
+    int FrameCount() const override { return reader.FrameCount(); }
+    int Width() const override { return reader.Width(); }
+    int Height() const override { return reader.Height(); }
+    int Depth() const override { return reader.Depth(); }
+
+    const VoxelGrid<float>* Frame(int n) override;
+    bool Resident() const override { return false; }
+
+    double LastReadSeconds() const { return lastReadSeconds; }
+
+private:
+    struct Entry {
+        int frame = -1;
+        VoxelGrid<float> grid{ 0, 0, 0 };
+    };
+
+    SimFileReader reader;
+    Entry cache[2];
+    int next = 0; // Least recently used entry
+    double lastReadSeconds = 0.0;
+};
@@ -0,0 +1,100 @@
+#include "FrameStats.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const float minSeconds = 1e-4f;
+const float bucketsPerDecade = FrameStats::Buckets / 4.0f;
+
+}
+
+FrameStats::FrameStats(int window)
+    : times(std::max(window, 1)), maxQueue(std::max(window, 1)) {}
+
+void FrameStats::Clear() {
+    head = count = 0;
+    sum = 0.0;
+    maxHead = maxCount = 0;
+    std::fill(std::begin(histogram), std::end(histogram), 0);
+}
+
+int FrameStats::Bucket(float seconds) {
+    if (seconds <= minSeconds)
+        return 0;
+    int b = static_cast<int>(std::log10(seconds / minSeconds) * bucketsPerDecade);
+    return std::min(b, Buckets - 1);
+}
+
+float FrameStats::BucketLow(int bucket) {
+    return minSeconds * std::pow(10.0f, bucket / bucketsPerDecade);
+}
+
+void FrameStats::Add(float seconds) {
+    const int window = static_cast<int>(times.size());
+
+    if (count == window) {
+        // Evict the oldest sample
+        float old = times[head];
+        sum -= old;
+        histogram[Bucket(old)]--;
+        if (maxCount > 0 && maxQueue[maxHead] == head) {
+            maxHead = (maxHead + 1) % window;
+            maxCount--;
+        }
+    }
+    else {
+        count++;
+    }
+
+    times[head] = seconds;
+    sum += seconds;
+    histogram[Bucket(seconds)]++;
+
+    // Drop queued samples this one dominates; they can never be the max again
+    while (maxCount > 0 && times[maxQueue[(maxHead + maxCount - 1) % window]] <= seconds)
+        maxCount--;
+    maxQueue[(maxHead + maxCount) % window] = head;
+    maxCount++;
+
+    head = (head + 1) % window;
+
+    // Re-sum once per lap so rounding in the running total can't accumulate
+    if (head == 0) {
+        sum = 0.0;
+        for (int i = 0; i < count; ++i)
+            sum += times[i];
+    }
+}
+
+float FrameStats::Last() const {
+    if (count == 0)
+        return 0.0f;
+    const int window = static_cast<int>(times.size());
+    return times[(head + window - 1) % window];
+}
+
+float FrameStats::Max() const {
+    return maxCount ? times[maxQueue[maxHead]] : 0.0f;
+}
+
+float FrameStats::Percentile(float p) const {
+    if (count == 0)
+        return 0.0f;
+
+    // Rank of the wanted sample, then interpolate within its bucket
+    float rank = std::clamp(p, 0.0f, 1.0f) * count;
+    int seen = 0;
+    for (int b = 0; b < Buckets; ++b) {
+        if (histogram[b] == 0)
+            continue;
+        if (seen + histogram[b] >= rank) {
+            float t = (rank - seen) / histogram[b];
+            float low = BucketLow(b), high = BucketLow(b + 1);
+            return std::min(low + (high - low) * t, Max());
+        }
+        seen += histogram[b];
+    }
+    return Max();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Rolling statistics over the most recent frame times. Every query is O(1)
+// except Percentile, which walks a fixed number of histogram buckets, so the
+// overlay can show hitches without re-scanning the window each frame.
+class FrameStats {
+public:
+    // Log-spaced histogram from 0.1 ms to 1 s, about 7% per bucket
+    static constexpr int Buckets = 128;
+
+    explicit FrameStats(int window = 144);
+
+    void Add(float seconds);
+    void Clear();
+
+    int Count() const { return count; }
+    float Last() const;
+    float Mean() const { return count ? static_cast<float>(sum / count) : 0.0f; }
+    float Max() const;
+    // Frame time at or below which a fraction `p` (0-1) of the window falls,
+    // to within one histogram bucket.
+    float Percentile(float p) const;
+
+private:
+    static int Bucket(float seconds);
+    static float BucketLow(int bucket);
+
+    std::vector<float> times; // Ring of the last `window` samples
+    int head = 0;             // Next slot to write
+    int count = 0;
+    double sum = 0.0;
+
+    // Indices into `times` of decreasing values, oldest first; the front is the max
+    std::vector<int> maxQueue;
+    int maxHead = 0, maxCount = 0;
+
+    int histogram[Buckets] = {};
+};
@@ -6,23 +6,37 @@
 #include "Game.h"
 #include "GameLog.hpp"
 #include "VoxelGrid.hpp"
+#include "SmokeSolver.hpp"
+#include "SimulationThread.hpp"
+#include "SimFile.hpp"
+#include "AsciiSim.hpp"
+#include "Camera.hpp"
+#include "FrameSource.hpp"
+#include "FrameStats.hpp"
+#include "Profiler.hpp"
+#include "ProgressiveRenderer.hpp"
+#include "TransferFunction.hpp"
+#include "VolumeUpload.hpp"
+#include "VolumeRing.hpp"
 #include "imgui-1.91.5/imgui.h"
 #include "imgui-1.91.5/backends/imgui_impl_win32.h"
 #include "imgui-1.91.5/backends/imgui_impl_dx11.h"
 
 #include <string>
-#include <deque>
 #include <iostream>
 #include <fstream>
 #include <thread>
 #include <atomic>
 #include <filesystem>
+#include <chrono>
+#include <cstring>
 
 #include "d3dcompiler.h"
 
 extern void ExitGame() noexcept;
 
 using namespace DirectX;
+using namespace std;
 
 using Microsoft::WRL::ComPtr;
 
@@ -30,13 +44,16 @@ using Microsoft::WRL::ComPtr;
 const int winWidth = 1000;
 const int winHeight = 800;
 
-std::deque<float> frameTimes;
-int fps;
-int maxFrames = 144;
-float alpha = 0.1f; // Smoothing factor (0.0f to 1.0f)
+vector<LogEntry> logSnapshot; // Reused by the overlay each frame
+
+// Real frame-to-frame times; the fixed-step timer always reports 1/60
+FrameStats frameStats(144);
+std::chrono::steady_clock::time_point lastTick;
+bool hasLastTick;
 
 const int simWinWidth = 200;
-const int simWinHeight = 250;
+const int simWinHeight = 430;
+const int shadingWinHeight = 360;
 const int margin = 20;
 
 atomic<bool> loadingFile = false;
@@ -44,11 +61,42 @@ atomic<float> loadProgress = 0.0f;
 atomic<int> simLoadedFrames = 0;
 string simPath(255, '\0');
 int simFrame;
+float simPosition;
+float playbackSpeed = 1.0f; // Stored frames per tick
+bool interpolateFrames = true;
 int simTotalFrames;
 int simX, simY, simZ;
 vector<VoxelGrid<float>> simFrameData;
+string simStreamPath; // Set instead of simFrameData for containers streamed from disk
 bool simLoaded;
-bool simPlaying;
+atomic<bool> savingFile = false;
+
+// Containers bigger than this are streamed rather than loaded
+const uint64_t streamThresholdBytes = 1ull << 30;
+
+// Timeline scrubbing
+int scrubFrame;
+bool scrubbing;
+bool seekPending;
+std::chrono::steady_clock::time_point seekStart;
+float seekLatencyMs = -1.0f;
+
+// Profiling, viewable in chrome://tracing or Perfetto
+bool profiling;
+const string tracePath = "profile.json";
+
+// Live solver
+const int liveX = 64, liveY = 128, liveZ = 64;
+const float liveTimeScale = 8.0f; // Solver seconds per wall-clock second
+const string checkpointPath = "Simulations\\checkpoint.smk";
+const int checkpointInterval = 600; // Solver steps
+bool showTracers; // Render tracer particles instead of the smoke density
+
+// Playback and the live solver run on their own thread
+const double simRate = 60.0;
+SimulationThread simThread;
+SimFrame shownFrame;
+bool hasShownFrame;
 
 Game::Game() noexcept :
     m_window(nullptr),
@@ -65,8 +113,180 @@ ID3D11Buffer* indexBuffer;
 ID3D11Buffer* vertexBuffer;
 ID3D11InputLayout* inputLayout;
 
-ID3D11Texture3D* tex3D = nullptr;
-ID3D11ShaderResourceView* srv = nullptr;
+// Transfer-function shading: Shader.hlsl compiled with SHADING 1 and 2,
+// reading the baked tables from small textures
+const char* shadingNames[] = { "Classic", "Transfer", "Pre-integrated" };
+int shadingMode = 0;
+ID3D11PixelShader* transferShaders[2] = {};
+const float classicStepSize = 0.001f;
+int transferStepScale = 4; // Transfer modes step this many classic steps at once
+TransferFunction transferFunction = TransferFunction::Default();
+uint64_t transferUploaded = 0;
+ID3D11Texture1D* transferLutTexture = nullptr;
+ID3D11Texture2D* preIntegratedTexture = nullptr;
+ID3D11ShaderResourceView* transferViews[2] = {};
+ID3D11Buffer* transferConstants = nullptr;
+
+// Sphere-traced solids: every shading variant compiled again with SOLIDS 1
+bool traceSolids = false;
+ID3D11PixelShader* tracedShaders[3] = {};
+
+// Matches cbuffer TransferConstants in Shader.hlsl
+struct TransferConstantData
+{
+    float maxDensity;
+    float stepSize;
+    float segmentLength;
+    float padding;
+};
+
+// Mouse drags orbit or look around, the wheel zooms and the right button
+// pans; WASD/QE fly
+const char* cameraModeNames[] = { "Orbit", "Fly" };
+Camera camera;
+ID3D11Buffer* cameraConstants = nullptr;
+
+// Matches cbuffer CameraConstants in Shader.hlsl
+struct CameraConstantData
+{
+    float invViewProj[16];
+    Vector3 position;
+    float padding;
+};
+
+CameraConstantData cameraUploaded = {};
+
+// Progressive refinement: the smoke is marched into a float history target
+// in refineSchedule's passes, each blended in with the pass weight, and the
+// history is blitted to the back buffer. Camera motion restarts with a
+// preview; new frames and shading changes restart with one full pass.
+bool progressiveEnabled = false;
+RefineSchedule refineSchedule;
+ID3D11Texture2D* historyTexture = nullptr;
+ID3D11RenderTargetView* historyTarget = nullptr;
+ID3D11ShaderResourceView* historyView = nullptr;
+ID3D11BlendState* accumulateBlend = nullptr;
+ID3D11PixelShader* blitShader = nullptr;
+ID3D11Buffer* refineConstants = nullptr;
+bool historyStale = true;   // Set when the target is recreated or progressive is switched on
+int refineShading = -1;     // Shading the history was drawn with
+bool refineTraced = false;  // Solid variant the history was drawn with
+uint64_t refineTransfer = 0;
+
+// Time from a restart until the GPU finishes the first and the converged
+// pass, polled from event queries
+ID3D11Query* refineQueries[2] = {};
+bool refinePending[2] = {};
+std::chrono::steady_clock::time_point refineStart;
+float refineMs[2] = {};
+
+// Matches cbuffer RefineConstants in Shader.hlsl
+struct RefineConstantData
+{
+    float stepScale;
+    float stepOffset;
+    float historyScale[2];
+};
+
+// The density texture as an upload target. Full uploads are written into a
+// staging copy and copied across on the GPU; changed bricks go straight into
+// the default-usage texture with UpdateSubresource.
+class TextureUploadTarget : public IVolumeUploadTarget
+{
+public:
+    ID3D11DeviceContext* context = nullptr;
+    ID3D11Texture3D* texture = nullptr;
+    ID3D11Texture3D* staging = nullptr;
+    int width = 0, height = 0, depth = 0;
+
+    int Width() const override { return width; }
+    int Height() const override { return height; }
+    int Depth() const override { return depth; }
+
+    bool Map(MappedVolume& mapped) override
+    {
+        D3D11_MAPPED_SUBRESOURCE res = {};
+        DX::ThrowIfFailed(context->Map(staging, 0, D3D11_MAP_WRITE, 0, &res));
+        mapped.data = res.pData;
+        mapped.rowPitch = res.RowPitch;
+        mapped.depthPitch = res.DepthPitch;
+        return true;
+    }
+
+    void Unmap() override
+    {
+        context->Unmap(staging, 0);
+        context->CopyResource(texture, staging);
+    }
+
+    bool SupportsBoxes() const override { return true; }
+
+    void UpdateBox(const BrickRange& box, const float* src, size_t rowPitch, size_t depthPitch) override
+    {
+        D3D11_BOX b = {};
+        b.left = box.x0;
+        b.top = box.y0;
+        b.front = box.z0;
+        b.right = box.x1;
+        b.bottom = box.y1;
+        b.back = box.z1;
+        context->UpdateSubresource(texture, 0, &b, src, static_cast<UINT>(rowPitch), static_cast<UINT>(depthPitch));
+    }
+};
+
+// The density textures the renderer rotates through. A slot is idle once
+// the event query issued after its last draw has completed.
+class TextureRing : public IVolumeDevice
+{
+public:
+    ID3D11DeviceContext* context = nullptr;
+    vector<TextureUploadTarget> targets;
+    vector<ID3D11ShaderResourceView*> views;
+    vector<ID3D11Query*> queries;
+    vector<bool> fenced;
+
+    int SlotCount() const override { return static_cast<int>(targets.size()); }
+    IVolumeUploadTarget& Slot(int slot) override { return targets[slot]; }
+
+    void Bind(int slot) override
+    {
+        context->PSSetShaderResources(0, 1, &views[slot]);
+    }
+
+    void Fence(int slot) override
+    {
+        context->End(queries[slot]);
+        fenced[slot] = true;
+    }
+
+    bool Idle(int slot) override
+    {
+        if (!fenced[slot])
+            return true;
+        if (context->GetData(queries[slot], nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+            return false;
+        fenced[slot] = false;
+        return true;
+    }
+
+    void Release()
+    {
+        for (auto& t : targets) {
+            if (t.texture) t.texture->Release();
+            if (t.staging) t.staging->Release();
+        }
+        for (auto v : views) if (v) v->Release();
+        for (auto q : queries) if (q) q->Release();
+        targets.clear();
+        views.clear();
+        queries.clear();
+        fenced.clear();
+    }
+};
+
+int volumeRingDepth = 3; // Textures in flight: the drawn one, one the GPU may still read, and the rest uploaded ahead
+TextureRing textureRing;
+VolumeRing volumeRing;
 
 struct Vertex
 {
@@ -81,6 +301,8 @@ void Game::Initialize(HWND window, int width, int height)
     m_outputWidth = std::max(width, 1);
     m_outputHeight = std::max(height, 1);
 
+    Profiler::SetThreadName("Render");
+
     CreateDevice();
 
     CreateResources();
@@ -107,6 +329,47 @@ void Game::Initialize(HWND window, int width, int height)
     D3DCompileFromFile(L"Shader.hlsl", nullptr, nullptr, "PS", "ps_5_0", D3DCOMPILE_ENABLE_STRICTNESS, 0, &psBlob, nullptr);
     m_d3dDevice->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &pixelShader);
 
+    for (int i = 0; i < 2; ++i)
+    {
+        const char* variant = i == 0 ? "1" : "2";
+        D3D_SHADER_MACRO defines[] = { { "SHADING", variant }, { nullptr, nullptr } };
+        ID3DBlob* blob = nullptr;
+        D3DCompileFromFile(L"Shader.hlsl", defines, nullptr, "PS", "ps_5_0", D3DCOMPILE_ENABLE_STRICTNESS, 0, &blob, nullptr);
+        if (blob)
+        {
+            m_d3dDevice->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &transferShaders[i]);
+            blob->Release();
+        }
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        const char* variant[] = { "0", "1", "2" };
+        D3D_SHADER_MACRO defines[] = { { "SHADING", variant[i] }, { "SOLIDS", "1" }, { nullptr, nullptr } };
+        ID3DBlob* blob = nullptr;
+        D3DCompileFromFile(L"Shader.hlsl", defines, nullptr, "PS", "ps_5_0", D3DCOMPILE_ENABLE_STRICTNESS, 0, &blob, nullptr);
+        if (blob)
+        {
+            m_d3dDevice->CreatePixelShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, &tracedShaders[i]);
+            blob->Release();
+        }
+    }
+    CreateTransferResources();
+
+    D3D11_BUFFER_DESC cameraDesc = {};
+    cameraDesc.Usage = D3D11_USAGE_DEFAULT;
+    cameraDesc.ByteWidth = sizeof(CameraConstantData);
+    cameraDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    m_d3dDevice->CreateBuffer(&cameraDesc, nullptr, &cameraConstants);
+
+    ID3DBlob* blitBlob = nullptr;
+    D3DCompileFromFile(L"Shader.hlsl", nullptr, nullptr, "Blit", "ps_5_0", D3DCOMPILE_ENABLE_STRICTNESS, 0, &blitBlob, nullptr);
+    if (blitBlob)
+    {
+        m_d3dDevice->CreatePixelShader(blitBlob->GetBufferPointer(), blitBlob->GetBufferSize(), nullptr, &blitShader);
+        blitBlob->Release();
+    }
+    CreateRefineResources();
+
     D3DCompileFromFile(L"Shader.hlsl", nullptr, nullptr, "VS", "vs_5_0", D3DCOMPILE_ENABLE_STRICTNESS, 0, &vsBlob, nullptr);
     m_d3dDevice->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &vertexShader);
 
@@ -182,6 +445,14 @@ void Game::Initialize(HWND window, int width, int height)
 // Executes the basic game loop.
 void Game::Tick()
 {
+    auto now = std::chrono::steady_clock::now();
+    if (hasLastTick)
+    {
+        frameStats.Add(std::chrono::duration<float>(now - lastTick).count());
+    }
+    lastTick = now;
+    hasLastTick = true;
+
     m_timer.Tick([&]()
     {
         Update(m_timer);
@@ -193,57 +464,68 @@ void Game::Tick()
 // Updates the world.
 void Game::Update(DX::StepTimer const& timer)
 {
-    float elapsedTime = float(timer.GetElapsedSeconds());
-
-
-    // TODO: Add your game logic here.
-    if (simPlaying) {
-        simFrame++;
-        if (simFrame >= simTotalFrames) {
-            simPlaying = false;
-            simFrame = 0;
-        }
-    }
-    
-    // Store the elapsed time for this frame
-    frameTimes.push_back(elapsedTime);
-
-    // Remove the oldest frame if we've exceeded maxFrames
-    if (frameTimes.size() > maxFrames)
-    {
-        frameTimes.pop_front();
-    }
-
-    // Calculate the average frame time
-    float averageFrameTime = 0.0f;
-    for (float time : frameTimes)
-    {
-        averageFrameTime += time;
-    }
-    averageFrameTime /= frameTimes.size();
-
-    // Calculate FPS from the average frame time
-    fps = static_cast<int>(1.0f / averageFrameTime);
+    PROFILE_SCOPE("Update");
+    UNREFERENCED_PARAMETER(timer);
 }
 
 void Game::LoadSimulation(const std::string& path) {
+    Profiler::SetThreadName("Loader");
+    PROFILE_SCOPE("LoadSimulation");
+
     simLoaded = false;
     loadProgress = 0.0f;
     loadingFile = true;
     simTotalFrames = 0;
     simFrameData.clear();
+    simStreamPath.clear();
+
+    // Binary container
+    if (SimFile::IsContainer(path)) {
+        SimFileReader reader;
+        if (reader.Open(path)) {
+            simX = reader.Width();
+            simY = reader.Height();
+            simZ = reader.Depth();
+            simTotalFrames = reader.FrameCount();
+
+            // Too big to hold: play it straight from disk via the frame index
+            uint64_t frameBytes = static_cast<uint64_t>(simX) * simY * simZ * sizeof(float);
+            if (frameBytes * simTotalFrames > streamThresholdBytes) {
+                if (!reader.Indexed())
+                    PrintLog("No frame index in " + path + ", seeking will scan the file on open", LogLevel::Warning);
+                simStreamPath = path;
+                loadingFile = false;
+                return;
+            }
 
-    std::filesystem::path dirPath = std::filesystem::path(path).parent_path();
+            for (int i = 0; i < simTotalFrames; i++) {
+                VoxelGrid<float> gridData(simX, simY, simZ);
+                if (reader.ReadFrame(i, gridData))
+                    simFrameData.push_back(std::move(gridData));
+                else
+                    PrintLog("Could not read frame " + to_string(i) + " of " + path, LogLevel::Warning);
+
+                simLoadedFrames = i;
+                loadProgress = static_cast<float>(simLoadedFrames) / simTotalFrames;
+            }
+            // Playback and the timeline index the frames actually held
+            simTotalFrames = static_cast<int>(simFrameData.size());
+            PrintLog("Loaded " + to_string(simFrameData.size()) + " frames from " + path);
+        }
+        else {
+            PrintLog("Could not open " + path, LogLevel::Error);
+        }
+        loadingFile = false;
+        return;
+    }
 
-    std::ifstream infoFile(path);
-    if (!infoFile.is_open()) {
+    if (!AsciiSim::ReadInfo(path, simTotalFrames, simX, simY, simZ)) {
+        PrintLog("Could not open " + path, LogLevel::Error);
+        simTotalFrames = 0;
         loadingFile = false;
         return; // File is not valid
     }
 
-    infoFile >> simTotalFrames >> simX >> simY >> simZ;
-    infoFile.close();
-
     if (simTotalFrames <= 0) {
         loadingFile = false;
         return; // No data to load
@@ -251,42 +533,98 @@ void Game::LoadSimulation(const std::string& path) {
 
     for (int i = 0; i < simTotalFrames; i++) {
         VoxelGrid<float> gridData(simX, simY, simZ);
-        std::filesystem::path framePath = dirPath / ("frame" + std::to_string(i));
-
-        std::ifstream frameFile(framePath);
-        if (frameFile.is_open()) {
-            for (int k = 0; k < simZ; ++k)
-                for (int j = 0; j < simY; ++j)
-                    for (int i = 0; i < simX; ++i) {
-                        double density;
-                        float fdensity = 0.0f;
-                        frameFile >> density;
-                        if (density > 0)
-                            fdensity = static_cast<float>(density);
-                        gridData.At(i, j, k) = fdensity;
-                    }
-            simFrameData.push_back(gridData);
-        }
-        frameFile.close();
+        string framePath = AsciiSim::FramePath(path, i);
+        if (AsciiSim::ReadFrame(framePath, gridData)) {
+            simFrameData.push_back(std::move(gridData));
+        }
+        else {
+            PrintLog("Missing " + framePath, LogLevel::Warning);
+        }
 
         simLoadedFrames = i;  // Update the number of loaded frames
         loadProgress = static_cast<float>(simLoadedFrames) / simTotalFrames;  // Update progress
     }
 
+    simTotalFrames = static_cast<int>(simFrameData.size());
+    PrintLog("Loaded " + to_string(simFrameData.size()) + " frames from " + path);
     loadingFile = false;
+}
+
+void Game::SaveSimulation(const std::string& path) {
+    SimFileWriter writer;
+    bool ok = writer.Open(path, simX, simY, simZ);
+    for (int i = 0; ok && i < static_cast<int>(simFrameData.size()); i++) {
+        ok = writer.WriteFrame(i, simFrameData[i]);
+    }
+    ok = writer.Close() && ok;
+
+    PrintLog(ok ? "Saved " + path : "Could not save " + path, ok ? LogLevel::Info : LogLevel::Error);
+    savingFile = false;
+}
+
+void Game::StartPlayback() {
+    CreateVolumeTexture(simX, simY, simZ);
+    if (!simStreamPath.empty()) {
+        auto source = make_unique<StreamingFrameSource>();
+        if (!source->Open(simStreamPath)) {
+            PrintLog("Could not open " + simStreamPath, LogLevel::Error);
+            return;
+        }
+        simThread.StartPlayback(std::move(source), simRate);
+    }
+    else {
+        simThread.StartPlayback(&simFrameData, simRate);
+    }
+}
+
+void Game::StartLiveSolver(bool resume) {
+    auto solver = make_unique<SmokeSolver>(liveX, liveY, liveZ);
+
+    SmokeSource source;
+    source.center = Vector3(liveX * 0.5f, liveY * 0.1f, liveZ * 0.5f);
+    source.radius = liveX * 0.08f;
+    source.velocity = Vector3(0.0f, 10.0f, 0.0f);
+    solver->sources.push_back(source);
+
+    if (resume && !LoadCheckpoint(checkpointPath, *solver)) {
+        PrintLog("No checkpoint to resume from " + checkpointPath, LogLevel::Warning);
+        return;
+    }
+
+    StopSimulationThread();
+    CreateVolumeTexture(liveX, liveY, liveZ);
+    simThread.SetCheckpoints(checkpointPath, checkpointInterval);
+    simThread.SetTracers(showTracers);
+    simThread.StartLive(std::move(solver), simRate, liveTimeScale);
+}
+
+void Game::StopSimulationThread() {
+    simThread.Stop();
+    hasShownFrame = false;
+}
+
+void Game::CreateVolumeTexture(int x, int y, int z) {
+    textureRing.Release();
+    textureRing.context = m_d3dContext.Get();
+
     // Configure Texture 3D
     D3D11_TEXTURE3D_DESC td = {};
-    td.Width = simX;
-    td.Height = simY;
-    td.Depth = simZ;
+    td.Width = x;
+    td.Height = y;
+    td.Depth = z;
     td.MipLevels = 1;
     td.Format = DXGI_FORMAT_R32_FLOAT;
-    td.Usage = D3D11_USAGE_DYNAMIC;
-    td.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-    td.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
     td.MiscFlags = 0;
 
-    m_d3dDevice->CreateTexture3D(&td, nullptr, &tex3D);
+    // CPU-writable twin for full uploads
+    D3D11_TEXTURE3D_DESC sd = td;
+    sd.Usage = D3D11_USAGE_STAGING;
+    sd.BindFlags = 0;
+    sd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    td.Usage = D3D11_USAGE_DEFAULT;
+    td.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    td.CPUAccessFlags = 0;
 
     CD3D11_SHADER_RESOURCE_VIEW_DESC srvd = {};
     srvd.Format = DXGI_FORMAT_R32_FLOAT;
@@ -294,9 +632,232 @@ void Game::LoadSimulation(const std::string& path) {
     srvd.Texture3D.MostDetailedMip = 0;
     srvd.Texture3D.MipLevels = 1;
 
-    m_d3dDevice->CreateShaderResourceView(tex3D, &srvd, &srv);
+    D3D11_QUERY_DESC qd = {};
+    qd.Query = D3D11_QUERY_EVENT;
+
+    textureRing.targets.resize(volumeRingDepth);
+    textureRing.views.resize(volumeRingDepth, nullptr);
+    textureRing.queries.resize(volumeRingDepth, nullptr);
+    textureRing.fenced.resize(volumeRingDepth, false);
+    for (int i = 0; i < volumeRingDepth; ++i) {
+        TextureUploadTarget& target = textureRing.targets[i];
+        target.context = m_d3dContext.Get();
+        target.width = x;
+        target.height = y;
+        target.depth = z;
+
+        m_d3dDevice->CreateTexture3D(&td, nullptr, &target.texture);
+        m_d3dDevice->CreateTexture3D(&sd, nullptr, &target.staging);
+        m_d3dDevice->CreateShaderResourceView(target.texture, &srvd, &textureRing.views[i]);
+        m_d3dDevice->CreateQuery(&qd, &textureRing.queries[i]);
+    }
+
+    volumeRing.lookahead = volumeRingDepth - 1;
+    volumeRing.Reset(textureRing);
+}
+
+void Game::CreateTransferResources() {
+    D3D11_TEXTURE1D_DESC ld = {};
+    ld.Width = TransferFunction::LutSize;
+    ld.MipLevels = 1;
+    ld.ArraySize = 1;
+    ld.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    ld.Usage = D3D11_USAGE_DEFAULT;
+    ld.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    m_d3dDevice->CreateTexture1D(&ld, nullptr, &transferLutTexture);
+    m_d3dDevice->CreateShaderResourceView(transferLutTexture, nullptr, &transferViews[0]);
+
+    D3D11_TEXTURE2D_DESC pd = {};
+    pd.Width = TransferFunction::PreIntegratedSize;
+    pd.Height = TransferFunction::PreIntegratedSize;
+    pd.MipLevels = 1;
+    pd.ArraySize = 1;
+    pd.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    pd.SampleDesc.Count = 1;
+    pd.Usage = D3D11_USAGE_DEFAULT;
+    pd.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    m_d3dDevice->CreateTexture2D(&pd, nullptr, &preIntegratedTexture);
+    m_d3dDevice->CreateShaderResourceView(preIntegratedTexture, nullptr, &transferViews[1]);
+
+    D3D11_BUFFER_DESC bd = {};
+    bd.Usage = D3D11_USAGE_DEFAULT;
+    bd.ByteWidth = sizeof(TransferConstantData);
+    bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    m_d3dDevice->CreateBuffer(&bd, nullptr, &transferConstants);
+
+    transferFunction.Bake(classicStepSize * transferStepScale);
+    UploadTransferFunction();
+}
+
+// Copies the tables and step constants to the GPU if they were rebaked.
+void Game::UploadTransferFunction() {
+    if (transferUploaded == transferFunction.Version()) {
+        return;
+    }
+    transferUploaded = transferFunction.Version();
+
+    m_d3dContext->UpdateSubresource(transferLutTexture, 0, nullptr, transferFunction.Lut().data(), 0, 0);
+    UINT rowPitch = TransferFunction::PreIntegratedSize * 4 * sizeof(float);
+    m_d3dContext->UpdateSubresource(preIntegratedTexture, 0, nullptr, transferFunction.PreIntegrated().data(), rowPitch, 0);
+
+    TransferConstantData constants = {};
+    constants.maxDensity = transferFunction.maxDensity;
+    constants.stepSize = classicStepSize * transferStepScale;
+    constants.segmentLength = transferFunction.SegmentLength();
+    m_d3dContext->UpdateSubresource(transferConstants, 0, nullptr, &constants, 0, 0);
+}
+
+// Size-independent state of progressive refinement; the history target is
+// made by CreateHistoryTarget.
+void Game::CreateRefineResources() {
+    D3D11_BUFFER_DESC bd = {};
+    bd.Usage = D3D11_USAGE_DEFAULT;
+    bd.ByteWidth = sizeof(RefineConstantData);
+    bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    m_d3dDevice->CreateBuffer(&bd, nullptr, &refineConstants);
+
+    // history = pass * weight + history * (1 - weight), weight in the blend factor
+    D3D11_BLEND_DESC blend = {};
+    D3D11_RENDER_TARGET_BLEND_DESC& rt = blend.RenderTarget[0];
+    rt.BlendEnable = TRUE;
+    rt.SrcBlend = D3D11_BLEND_BLEND_FACTOR;
+    rt.DestBlend = D3D11_BLEND_INV_BLEND_FACTOR;
+    rt.BlendOp = D3D11_BLEND_OP_ADD;
+    rt.SrcBlendAlpha = D3D11_BLEND_BLEND_FACTOR;
+    rt.DestBlendAlpha = D3D11_BLEND_INV_BLEND_FACTOR;
+    rt.BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    rt.RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    m_d3dDevice->CreateBlendState(&blend, &accumulateBlend);
+
+    D3D11_QUERY_DESC qd = {};
+    qd.Query = D3D11_QUERY_EVENT;
+    for (ID3D11Query*& query : refineQueries) {
+        m_d3dDevice->CreateQuery(&qd, &query);
+    }
+}
+
+// Float render target the progressive passes accumulate into, sized to the
+// window.
+void Game::CreateHistoryTarget() {
+    if (historyView) historyView->Release();
+    if (historyTarget) historyTarget->Release();
+    if (historyTexture) historyTexture->Release();
+
+    D3D11_TEXTURE2D_DESC td = {};
+    td.Width = static_cast<UINT>(m_outputWidth);
+    td.Height = static_cast<UINT>(m_outputHeight);
+    td.MipLevels = 1;
+    td.ArraySize = 1;
+    td.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    td.SampleDesc.Count = 1;
+    td.Usage = D3D11_USAGE_DEFAULT;
+    td.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    m_d3dDevice->CreateTexture2D(&td, nullptr, &historyTexture);
+    m_d3dDevice->CreateRenderTargetView(historyTexture, nullptr, &historyTarget);
+    m_d3dDevice->CreateShaderResourceView(historyTexture, nullptr, &historyView);
+    historyStale = true;
+}
+
+// Draws the next pass of refineSchedule into the history, restarting it
+// first if the view or the scene changed, then blits the history to the
+// back buffer. Expects the smoke pixel shader to be bound.
+void Game::RenderProgressive(bool viewChanged, bool sceneChanged)
+{
+    const uint64_t transferVersion = transferFunction.Version();
+    if (shadingMode != refineShading || traceSolids != refineTraced || (shadingMode > 0 && transferVersion != refineTransfer)) {
+        sceneChanged = true;
+    }
+    refineShading = shadingMode;
+    refineTraced = traceSolids;
+    refineTransfer = transferVersion;
+
+    if (viewChanged || sceneChanged || historyStale) {
+        refineSchedule.Restart(viewChanged || historyStale);
+        historyStale = false;
+        refineStart = std::chrono::steady_clock::now();
+        refineMs[0] = refineMs[1] = 0.0f;
+        refinePending[0] = refinePending[1] = false;
+    }
+
+    RefinePass pass;
+    if (refineSchedule.Next(pass)) {
+        D3D11_VIEWPORT viewport = { 0.0f, 0.0f, std::ceil(static_cast<float>(m_outputWidth) / pass.scale),
+            std::ceil(static_cast<float>(m_outputHeight) / pass.scale), 0.f, 1.f };
+        RefineConstantData constants = {};
+        constants.stepScale = pass.stepScale;
+        constants.stepOffset = pass.stepOffset;
+        constants.historyScale[0] = viewport.Width / m_outputWidth;
+        constants.historyScale[1] = viewport.Height / m_outputHeight;
+        m_d3dContext->UpdateSubresource(refineConstants, 0, nullptr, &constants, 0, 0);
+
+        const float factor[4] = { pass.weight, pass.weight, pass.weight, pass.weight };
+        m_d3dContext->OMSetRenderTargets(1, &historyTarget, nullptr);
+        m_d3dContext->RSSetViewports(1, &viewport);
+        m_d3dContext->OMSetBlendState(accumulateBlend, factor, 0xffffffff);
+        m_d3dContext->DrawIndexed(6, 0, 0);
+        m_d3dContext->OMSetBlendState(nullptr, nullptr, 0xffffffff);
 
-    m_d3dContext->PSSetShaderResources(0, 1, &srv);
+        if (refineSchedule.Completed() == 1) {
+            m_d3dContext->End(refineQueries[0]);
+            refinePending[0] = true;
+        }
+        if (refineSchedule.Converged()) {
+            m_d3dContext->End(refineQueries[1]);
+            refinePending[1] = true;
+        }
+        Clear();
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        if (refinePending[i] && m_d3dContext->GetData(refineQueries[i], nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK) {
+            refineMs[i] = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - refineStart).count();
+            refinePending[i] = false;
+        }
+    }
+
+    m_d3dContext->PSSetShader(blitShader, nullptr, 0);
+    m_d3dContext->PSSetShaderResources(3, 1, &historyView);
+    m_d3dContext->DrawIndexed(6, 0, 0);
+    ID3D11ShaderResourceView* none = nullptr;
+    m_d3dContext->PSSetShaderResources(3, 1, &none);
+}
+
+// Applies last frame's mouse and keyboard input to the camera and uploads
+// its constants for the current output size. Returns whether they changed.
+bool Game::UpdateCamera()
+{
+    const ImGuiIO& io = ImGui::GetIO();
+    if (!io.WantCaptureMouse) {
+        const float turn = 0.005f; // Radians per pixel
+        const float pan = camera.distance * 0.002f;
+        if (ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+            camera.Rotate(io.MouseDelta.x * turn, -io.MouseDelta.y * turn);
+        }
+        if (ImGui::IsMouseDown(ImGuiMouseButton_Right)) {
+            camera.Move(-io.MouseDelta.x * pan, io.MouseDelta.y * pan, 0.0f);
+        }
+        if (io.MouseWheel != 0.0f) {
+            camera.Zoom(std::pow(0.9f, io.MouseWheel));
+        }
+    }
+    if (!io.WantCaptureKeyboard && camera.mode == CameraMode::Fly) {
+        float speed = camera.distance * io.DeltaTime;
+        auto axis = [](ImGuiKey positive, ImGuiKey negative) {
+            return (ImGui::IsKeyDown(positive) ? 1.0f : 0.0f) - (ImGui::IsKeyDown(negative) ? 1.0f : 0.0f);
+        };
+        camera.Move(axis(ImGuiKey_D, ImGuiKey_A) * speed, axis(ImGuiKey_E, ImGuiKey_Q) * speed, axis(ImGuiKey_W, ImGuiKey_S) * speed);
+    }
+
+    CameraFrame frame = camera.Frame(m_outputWidth, m_outputHeight);
+    CameraConstantData constants = {};
+    std::copy(std::begin(frame.invViewProj), std::end(frame.invViewProj), constants.invViewProj);
+    constants.position = frame.position;
+    if (memcmp(&constants, &cameraUploaded, sizeof(constants)) == 0) {
+        return false;
+    }
+    cameraUploaded = constants;
+    m_d3dContext->UpdateSubresource(cameraConstants, 0, nullptr, &constants, 0, 0);
+    return true;
 }
 
 // Draws the scene.
@@ -308,31 +869,76 @@ void Game::Render()
         return;
     }
 
+    PROFILE_SCOPE("Render");
+
     Clear();
 
-    // Draw Smoke    
-    if (simLoaded) {
-        D3D11_MAPPED_SUBRESOURCE res = {};
-        DX::ThrowIfFailed(m_d3dContext->Map(tex3D, 0, D3D11_MAP_WRITE_DISCARD, 0, &res));
-        // Copy density data into the mapped resource
-        float* dest = reinterpret_cast<float*>(res.pData);
-        float* src = simFrameData[simFrame].Data();
-        size_t slicePitch = simX * simY;
+    // Pick up the newest frame the simulation thread has finished, if any
+    SimFrame nextFrame;
+    bool newFrame = false;
+    if (simThread.TakeLatest(nextFrame)) {
+        newFrame = true;
+        if (hasShownFrame) {
+            simThread.Release(shownFrame);
+        }
+        shownFrame = nextFrame;
+        hasShownFrame = true;
+        simFrame = shownFrame.index;
+        simPosition = static_cast<float>(shownFrame.position);
+    }
 
-        for (int z = 0; z < simZ; ++z) {
-            // Copy each slice
-            memcpy(dest + z * slicePitch, src + z * slicePitch, slicePitch * sizeof(float));
+    // Draw Smoke    
+    int volumeSlot = -1;
+    if (hasShownFrame) {
+        PROFILE_SCOPE("Volume upload");
+        volumeSlot = volumeRing.Show(textureRing, *shownFrame.grid, shownFrame.key);
+    }
+    if (volumeSlot >= 0) {
+        bool viewChanged = UpdateCamera();
+        m_d3dContext->PSSetConstantBuffers(1, 1, &cameraConstants);
+        m_d3dContext->PSSetConstantBuffers(2, 1, &refineConstants);
+        m_d3dContext->VSSetShader(vertexShader, nullptr, 0);
+        ID3D11PixelShader* traced = traceSolids ? tracedShaders[shadingMode] : nullptr;
+        if (shadingMode > 0 && transferShaders[shadingMode - 1]) {
+            UploadTransferFunction();
+            m_d3dContext->PSSetShaderResources(1, 2, transferViews);
+            m_d3dContext->PSSetConstantBuffers(0, 1, &transferConstants);
+            m_d3dContext->PSSetShader(traced ? traced : transferShaders[shadingMode - 1], nullptr, 0);
+        }
+        else {
+            m_d3dContext->PSSetShader(traced && shadingMode == 0 ? traced : pixelShader, nullptr, 0);
+        }
+        if (progressiveEnabled && blitShader) {
+            RenderProgressive(viewChanged, newFrame);
+        }
+        else {
+            RefineConstantData constants = { 1.0f, 0.0f, { 1.0f, 1.0f } };
+            m_d3dContext->UpdateSubresource(refineConstants, 0, nullptr, &constants, 0, 0);
+            m_d3dContext->DrawIndexed(6, 0, 0);
         }
+        volumeRing.EndFrame(textureRing);
 
-        // Unmap the texture to update it on the GPU
-        m_d3dContext->Unmap(tex3D, 0);
+        // Request to upload and draw, for the newest seek
+        if (shownFrame.seek && seekPending) {
+            seekLatencyMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - seekStart).count();
+            seekPending = false;
+        }
 
-        m_d3dContext->VSSetShader(vertexShader, nullptr, 0);
-        m_d3dContext->PSSetShader(pixelShader, nullptr, 0);
-        m_d3dContext->DrawIndexed(6, 0, 0);
+        // While that draw is in flight, upload the stored frames coming next.
+        // Blends are built on the simulation thread and can't be fetched ahead.
+        if (!simThread.Live() && simThread.Playing() && shownFrame.key >= 0) {
+            PROFILE_SCOPE("Volume prefetch");
+            for (int k = 1; k < volumeRing.lookahead; ++k) {
+                int next = shownFrame.index + k;
+                if (next >= static_cast<int>(simFrameData.size()) || !volumeRing.Prefetch(textureRing, simFrameData[next], next)) {
+                    break;
+                }
+            }
+        }
     }
 
     // ImGUI UI Render
+    int64_t imguiStart = Profiler::Enabled() ? Profiler::NowNs() : -1;
 
     ImGui_ImplDX11_NewFrame();
     ImGui_ImplWin32_NewFrame();
@@ -349,16 +955,29 @@ void Game::Render()
     winFlags |= ImGuiWindowFlags_NoCollapse;
 
     if (ImGui::Begin("Frame Counter", 0, winFlags)) {
-        string fpsText = "FPS " + std::to_string(fps);
-        ImGui::Text(fpsText.c_str());
-
-        for (auto& s : gameLog) {
-            ImGui::Text(s.c_str());
+        float mean = frameStats.Mean();
+        ImGui::Text("FPS %d (%.2f ms)", mean > 0.0f ? static_cast<int>(1.0f / mean + 0.5f) : 0, mean * 1000.0f);
+        ImGui::Text("p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms", frameStats.Percentile(0.5f) * 1000.0f,
+            frameStats.Percentile(0.95f) * 1000.0f, frameStats.Percentile(0.99f) * 1000.0f, frameStats.Max() * 1000.0f);
+        const VolumeRingStats& ring = volumeRing.Stats();
+        ImGui::Text("Volume ring %d: %llu hits, %llu misses, %llu stalls, %llu ahead", volumeRingDepth,
+            ring.hits, ring.misses, ring.stalls, ring.prefetches);
+
+        SnapshotLog(logSnapshot);
+        for (auto& entry : logSnapshot) {
+            if (entry.level == LogLevel::Info) {
+                ImGui::TextUnformatted(entry.text.c_str());
+            }
+            else {
+                ImVec4 color = entry.level == LogLevel::Error ? ImVec4(1.0f, 0.4f, 0.4f, 1.0f) : ImVec4(1.0f, 0.85f, 0.3f, 1.0f);
+                ImGui::TextColored(color, "%s", entry.text.c_str());
+            }
         }
     }
     ImGui::End();
 
-    ImGui::SetNextWindowPos(ImVec2(winWidth - simWinWidth - margin, margin), ImGuiCond_Once);
+    // Pinned to the right edge, following the window when it is resized
+    ImGui::SetNextWindowPos(ImVec2(static_cast<float>(m_outputWidth - simWinWidth - margin), margin), ImGuiCond_Always);
     ImGui::SetNextWindowSize(ImVec2(simWinWidth, simWinHeight), ImGuiCond_Once);
 
     winFlags = 0;
@@ -369,14 +988,54 @@ void Game::Render()
         ImGui::Text("File Path:");
         ImGui::InputText("##FilePath", simPath.data(), simPath.capacity(), ImGuiInputTextFlags_AutoSelectAll | ImGuiInputTextFlags_AllowTabInput);
 
-        ImGui::BeginDisabled(loadingFile);
+        ImGui::BeginDisabled(loadingFile || savingFile);
         if (ImGui::Button("Load Simulation")) {
             if (!loadingFile) {
+                StopSimulationThread();
+                simLoaded = false;
+                loadingFile = true;
                 thread(&Game::LoadSimulation, this, simPath).detach();
             }
         }
         ImGui::EndDisabled();
 
+        if (!simThread.Live()) {
+            ImGui::BeginDisabled(loadingFile);
+            if (ImGui::Button("Live Solver")) {
+                StartLiveSolver(false);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Resume")) {
+                StartLiveSolver(true);
+            }
+            ImGui::EndDisabled();
+        }
+        else {
+            if (ImGui::Button("Stop Solver")) {
+                StopSimulationThread();
+                if (simLoaded) {
+                    StartPlayback();
+                }
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Checkpoint")) {
+                simThread.RequestCheckpoint();
+            }
+            if (ImGui::Checkbox("Tracers", &showTracers)) {
+                simThread.SetTracers(showTracers);
+            }
+            const SolverStats& stats = shownFrame.stats;
+            ImGui::Text("Frame %.2f ms, %d substeps%s", stats.advanceSeconds * 1000.0, stats.substeps, stats.degraded ? " (degraded)" : "");
+            ImGui::Text("Step %.2f ms, %d iterations", stats.stepSeconds * 1000.0, stats.pressureIterations);
+            ImGui::Text("Active %.1f%% (%d/%d bricks)", stats.activeFraction * 100.0f, stats.activeBricks, stats.totalBricks);
+            if (simThread.LastCheckpointStep() >= 0) {
+                ImGui::Text("Checkpoint at step %d", simThread.LastCheckpointStep());
+            }
+            if (showTracers) {
+                ImGui::Text("Tracers %zu", simThread.TracerCount());
+            }
+        }
+
         ImGui::PushTextWrapPos(simWinWidth - margin);
         if (loadingFile) {
             int loadedFrames = simLoadedFrames.load();
@@ -384,38 +1043,168 @@ void Game::Render()
             ImGui::ProgressBar(loadProgress, ImVec2(-1, 0));
             ImGui::Text("Frames Loaded: %d / %d", loadedFrames, simTotalFrames);
         }
+        else if (!simStreamPath.empty()) {
+            if (!simLoaded) {
+                simLoaded = true;
+                StartPlayback();
+            }
+            ImGui::Text("Streaming %d frames from disk", simTotalFrames);
+        }
         else if (!simFrameData.empty()) {
-            simLoaded = true;
+            if (!simLoaded) {
+                simLoaded = true;
+                StartPlayback();
+            }
             ImGui::Text("Frame loading complete!");
             ImGui::Text("Total Frames Loaded: %d", simTotalFrames);
+
+            // Write an indexed container for fast loading and seeking
+            ImGui::BeginDisabled(savingFile || simThread.Live());
+            if (ImGui::Button("Save Container")) {
+                savingFile = true;
+                string savePath = std::filesystem::path(simPath.c_str()).replace_extension(".smk").string();
+                thread(&Game::SaveSimulation, this, savePath).detach();
+            }
+            ImGui::EndDisabled();
         }
         else if (simTotalFrames == 0) {
             ImGui::Text("No frames to load or invalid file.");
         }
         ImGui::PopTextWrapPos();
 
-        if (simLoaded) {
-            if (!simPlaying) {
+        if (simLoaded && !simThread.Live()) {
+            if (!simThread.Playing()) {
                 if (ImGui::Button("Play Simulation")) {
-                    simPlaying = true;
+                    simThread.SetPlaying(true);
                 }
             }
             else {
                 if (ImGui::Button("Stop Simulation")) {
-                    simPlaying = false;
+                    simThread.SetPlaying(false);
                 }                
             }
             if (ImGui::Button("Reset Simulation")) {
-                simPlaying = false;
-                simFrame = 0;
+                simThread.SetPlaying(false);
+                simThread.Seek(0);
+                seekStart = std::chrono::steady_clock::now();
+                seekPending = true;
+            }
+            if (ImGui::SliderFloat("Speed", &playbackSpeed, 0.05f, 4.0f, "%.2fx")) {
+                simThread.SetSpeed(playbackSpeed);
+            }
+            if (ImGui::Checkbox("Interpolate", &interpolateFrames)) {
+                simThread.SetInterpolate(interpolateFrames);
             }
-            ImGui::Text("Frame %d/%d", simFrame, simTotalFrames);
+            ImGui::Text("Frame %.2f/%d", simPosition, simTotalFrames);
+
+            // Timeline: follows playback unless being dragged
+            if (!scrubbing && !seekPending) {
+                scrubFrame = simFrame;
+            }
+            ImGui::SetNextItemWidth(-1);
+            if (ImGui::SliderInt("##Timeline", &scrubFrame, 0, std::max(simTotalFrames - 1, 0))) {
+                simThread.Seek(scrubFrame);
+                seekStart = std::chrono::steady_clock::now();
+                seekPending = true;
+            }
+            scrubbing = ImGui::IsItemActive();
+            if (seekLatencyMs >= 0.0f) {
+                ImGui::Text("Seek %.2f ms", seekLatencyMs);
+            }
+        }
+
+        if (ImGui::SliderInt("Ring", &volumeRingDepth, 2, 6) && !textureRing.targets.empty()) {
+            const TextureUploadTarget& t = textureRing.targets[0];
+            CreateVolumeTexture(t.width, t.height, t.depth);
+        }
+
+        if (ImGui::Checkbox("Profile", &profiling)) {
+            if (profiling) {
+                Profiler::Clear();
+            }
+            Profiler::SetEnabled(profiling);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Save Trace")) {
+            bool saved = Profiler::WriteChromeTrace(tracePath);
+            PrintLog(saved ? "Saved " + tracePath : "Could not save " + tracePath, saved ? LogLevel::Info : LogLevel::Error);
+        }
+    }
+    ImGui::End();
+
+    ImGui::SetNextWindowPos(ImVec2(static_cast<float>(m_outputWidth - simWinWidth - margin), simWinHeight + 2 * margin), ImGuiCond_Always);
+    ImGui::SetNextWindowSize(ImVec2(simWinWidth, shadingWinHeight), ImGuiCond_Once);
+
+    if (ImGui::Begin("Shading", 0, winFlags)) {
+        ImGui::Combo("##Shading", &shadingMode, shadingNames, IM_ARRAYSIZE(shadingNames));
+        ImGui::Checkbox("Sphere-trace solids", &traceSolids);
+
+        bool rebake = false;
+        ImGui::BeginDisabled(shadingMode == 0);
+        rebake |= ImGui::SliderInt("Step x", &transferStepScale, 1, 8);
+        ImGui::SetNextItemWidth(-1);
+        rebake |= ImGui::DragFloat("##MaxDensity", &transferFunction.maxDensity, 0.01f, 0.05f, 10.0f, "Max density %.2f");
+
+        // Control points: colour, density and extinction
+        int removePoint = -1;
+        for (int i = 0; i < static_cast<int>(transferFunction.points.size()); ++i) {
+            TransferPoint& point = transferFunction.points[i];
+            ImGui::PushID(i);
+            rebake |= ImGui::ColorEdit3("##Color", &point.color.x, ImGuiColorEditFlags_NoInputs);
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(50);
+            rebake |= ImGui::DragFloat("##Density", &point.density, 0.005f, 0.0f, transferFunction.maxDensity, "%.2f");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(50);
+            rebake |= ImGui::DragFloat("##Extinction", &point.extinction, 0.05f, 0.0f, 200.0f, "%.1f");
+            ImGui::SameLine();
+            if (ImGui::Button("x") && transferFunction.points.size() > 1) {
+                removePoint = i;
+            }
+            ImGui::PopID();
+        }
+        if (removePoint >= 0) {
+            transferFunction.points.erase(transferFunction.points.begin() + removePoint);
+            rebake = true;
+        }
+        if (ImGui::Button("Add Point")) {
+            TransferPoint point = transferFunction.points.back();
+            point.density = std::min(point.density + 0.1f, transferFunction.maxDensity);
+            transferFunction.points.push_back(point);
+            rebake = true;
+        }
+        ImGui::EndDisabled();
+
+        if (rebake) {
+            transferFunction.Bake(classicStepSize * transferStepScale);
+        }
+
+        ImGui::SeparatorText("Camera");
+        int cameraMode = static_cast<int>(camera.mode);
+        if (ImGui::Combo("##CameraMode", &cameraMode, cameraModeNames, IM_ARRAYSIZE(cameraModeNames))) {
+            camera.SetMode(static_cast<CameraMode>(cameraMode));
+        }
+        ImGui::SliderAngle("FOV", &camera.fovY, 20.0f, 120.0f);
+        if (ImGui::Button("Reset View")) {
+            camera = Camera();
+        }
+
+        if (ImGui::Checkbox("Progressive", &progressiveEnabled) && progressiveEnabled) {
+            historyStale = true;
+        }
+        if (progressiveEnabled) {
+            ImGui::SameLine();
+            ImGui::Text("%d/%d", refineSchedule.Completed(), refineSchedule.Total());
+            ImGui::Text("First %.1f ms, done %.1f ms", refineMs[0], refineMs[1]);
         }
     }
     ImGui::End();
 
     ImGui::Render();
     ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+    if (imguiStart >= 0) {
+        Profiler::Record("ImGui", imguiStart, Profiler::NowNs());
+    }
 
     Present();
 }
@@ -472,6 +1261,7 @@ void Game::OnSuspending()
 void Game::OnResuming()
 {
     m_timer.ResetElapsedTime();
+    hasLastTick = false; // Time spent suspended is not a frame
 
     // TODO: Game is being power-resumed (or returning from minimize).
 }
@@ -655,7 +1445,7 @@ void Game::CreateResources()
 
     DX::ThrowIfFailed(m_d3dDevice->CreateDepthStencilView(depthStencil.Get(), nullptr, m_depthStencilView.ReleaseAndGetAddressOf()));
 
-    // TODO: Initialize windows-size dependent objects here.
+    CreateHistoryTarget();
 }
 
 void Game::OnDeviceLost()
@@ -41,6 +41,17 @@ public:
 private:
 
     void LoadSimulation(const std::string& path);
+    void SaveSimulation(const std::string& path);
+    void StartPlayback();
+    void StartLiveSolver(bool resume);
+    void StopSimulationThread();
+    void CreateVolumeTexture(int x, int y, int z);
+    void CreateTransferResources();
+    void UploadTransferFunction();
+    bool UpdateCamera();
+    void CreateRefineResources();
+    void CreateHistoryTarget();
+    void RenderProgressive(bool viewChanged, bool sceneChanged);
 
     void Update(DX::StepTimer const& timer);
     void Render();
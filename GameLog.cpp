@@ -0,0 +1,109 @@
+#include "GameLog.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+const int textWords = (GameLog::MaxText + 1 + 7) / 8;
+
+// A slot is a seqlock: seq is odd while a producer writes it and 2 * pos + 2
+// once it holds entry `pos`. Fields are atomics so readers racing a writer
+// see torn data (then discarded) rather than undefined behaviour.
+struct Slot {
+    std::atomic<uint64_t> seq = 0;
+    std::atomic<uint32_t> level = 0;
+    std::atomic<int64_t> micros = 0;
+    std::atomic<uint64_t> text[textWords] = {};
+};
+
+Slot slots[GameLog::Capacity];
+std::atomic<uint64_t> head = 0;    // Next entry position
+std::atomic<uint64_t> cleared = 0; // Entries before this are hidden
+
+const auto origin = std::chrono::steady_clock::now(); // Program start, for timestamps
+
+const char* LevelPrefix(LogLevel level) {
+    switch (level) {
+    case LogLevel::Warning: return "Warning: ";
+    case LogLevel::Error: return "Error: ";
+    default: return "";
+    }
+}
+
+}
+
+void PrintLog(const std::string& str, LogLevel level) {
+    int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+
+    char buffer[textWords * 8] = {};
+    std::snprintf(buffer, GameLog::MaxText + 1, "[%8.2f] %s%s", micros / 1e6, LevelPrefix(level), str.c_str());
+
+    uint64_t pos = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[pos % GameLog::Capacity];
+
+    // Claim the slot. Another producer is only ever here if the ring wrapped
+    // all the way round while it was mid-write; wait that out, and give up if
+    // a newer entry already took the slot.
+    uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+    for (;;) {
+        if (seq > 2 * pos)
+            return;
+        if (seq & 1) {
+            std::this_thread::yield();
+            seq = slot.seq.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (slot.seq.compare_exchange_weak(seq, 2 * pos + 1, std::memory_order_acquire, std::memory_order_relaxed))
+            break;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.level.store(static_cast<uint32_t>(level), std::memory_order_relaxed);
+    slot.micros.store(micros, std::memory_order_relaxed);
+    for (int i = 0; i < textWords; ++i) {
+        uint64_t word;
+        std::memcpy(&word, buffer + i * 8, 8);
+        slot.text[i].store(word, std::memory_order_relaxed);
+    }
+
+    slot.seq.store(2 * pos + 2, std::memory_order_release);
+}
+
+void ClearLog() {
+    cleared.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void SnapshotLog(std::vector<LogEntry>& out) {
+    out.clear();
+
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t begin = end > GameLog::Capacity ? end - GameLog::Capacity : 0;
+    begin = std::max(begin, cleared.load(std::memory_order_relaxed));
+
+    char buffer[textWords * 8];
+    for (uint64_t pos = begin; pos < end; ++pos) {
+        const Slot& slot = slots[pos % GameLog::Capacity];
+        uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != 2 * pos + 2)
+            continue; // Not written yet, being written, or already overwritten
+
+        uint32_t level = slot.level.load(std::memory_order_relaxed);
+        int64_t micros = slot.micros.load(std::memory_order_relaxed);
+        for (int i = 0; i < textWords; ++i) {
+            uint64_t word = slot.text[i].load(std::memory_order_relaxed);
+            std::memcpy(buffer + i * 8, &word, 8);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq)
+            continue; // Overwritten while copying
+
+        buffer[GameLog::MaxText] = '\0';
+        out.push_back({ static_cast<LogLevel>(level), micros / 1e6, buffer });
+    }
+}
@@ -1,14 +1,27 @@
+#pragma once
+
+#include <cstdint>
 #include <string>
 #include <vector>
 
-using namespace std;
+enum class LogLevel { Info, Warning, Error };
 
-vector<string> gameLog;
+struct LogEntry {
+    LogLevel level;
+    double seconds;   // Since program start (static initialisation of the log)
+    std::string text; // Already formatted for display, timestamp included
+};
 
-void PrintLog(string str) {
-    gameLog.push_back(str);
+// The log is a fixed-size ring shared by every thread. Producers never
+// block or allocate; once the ring is full the oldest entries are overwritten.
+namespace GameLog {
+    const int Capacity = 256;
+    const int MaxText = 120; // Longer messages are truncated
 }
 
-void ClearLog() {
-    gameLog.clear();
-}
\ No newline at end of file
+void PrintLog(const std::string& str, LogLevel level = LogLevel::Info);
+void ClearLog();
+
+// Copies the entries currently in the ring, oldest first, into `out`.
+// Never waits on producers; an entry being written at that moment is skipped.
+void SnapshotLog(std::vector<LogEntry>& out);
@@ -0,0 +1,134 @@
+#include "ParallelFor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Set on pool threads and on a caller while it drives a loop, so nested
+// calls run inline rather than re-entering the pool.
+thread_local bool insideLoop = false;
+
+class WorkerPool {
+public:
+    WorkerPool() {
+        unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 1; i < hw; ++i)
+            threads.emplace_back([this]() { WorkerLoop(); });
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads)
+            t.join();
+    }
+
+    int Size() const { return static_cast<int>(threads.size()) + 1; }
+
+    bool TryRun(int count, int grain, const std::function<void(int, int)>& fn) {
+        std::unique_lock<std::mutex> running(runMutex, std::try_to_lock);
+        if (!running.owns_lock() || threads.empty())
+            return false;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            body = &fn;
+            total = count;
+            chunk = grain;
+            next = 0;
+            pending = static_cast<int>(threads.size());
+            ++generation;
+        }
+        wake.notify_all();
+
+        Work();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return pending == 0; });
+        body = nullptr;
+        return true;
+    }
+
+private:
+    void Work() {
+        for (;;) {
+            int begin = next.fetch_add(chunk);
+            if (begin >= total)
+                break;
+            (*body)(begin, std::min(begin + chunk, total));
+        }
+    }
+
+    void WorkerLoop() {
+        insideLoop = true;
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [&]() { return quit || generation != seen; });
+            if (quit)
+                return;
+            seen = generation;
+
+            lock.unlock();
+            Work();
+            lock.lock();
+
+            if (--pending == 0)
+                done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::mutex runMutex; // Held by the thread currently driving a loop
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(int, int)>* body = nullptr;
+    int total = 0;
+    int chunk = 1;
+    std::atomic<int> next = 0;
+    int pending = 0;
+    uint64_t generation = 0;
+    bool quit = false;
+};
+
+WorkerPool& Pool() {
+    static WorkerPool pool;
+    return pool;
+}
+
+}
+
+void ParallelFor(int count, const std::function<void(int, int)>& body, int grain) {
+    if (count <= 0)
+        return;
+
+    WorkerPool& pool = Pool();
+    if (grain <= 0)
+        grain = std::max(1, count / (pool.Size() * 4));
+
+    if (count <= grain || insideLoop) {
+        body(0, count);
+        return;
+    }
+
+    insideLoop = true;
+    bool ran = pool.TryRun(count, grain, body);
+    insideLoop = false;
+    if (!ran)
+        body(0, count);
+}
+
+int ParallelWorkerCount() {
+    return Pool().Size();
+}
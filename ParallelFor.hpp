@@ -0,0 +1,13 @@
+#pragma once
+
+#include <functional>
+
+// Runs body(begin, end) over [0, count) in chunks of `grain` items spread
+// across a shared pool of worker threads. The calling thread takes part and
+// the call returns once every chunk has finished. If the pool is already busy
+// (nested or concurrent calls) the loop runs inline on the caller instead of
+// waiting for it. A grain of 0 picks one based on the worker count.
+void ParallelFor(int count, const std::function<void(int, int)>& body, int grain = 0);
+
+// Number of threads ParallelFor spreads work over, including the caller.
+int ParallelWorkerCount();
@@ -0,0 +1,166 @@
+#include "ParticleSplat.hpp"
+#include "BrickMask.hpp"
+#include "ParallelFor.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+const int brickSize = BrickMask::Size;
+
+// Voxel footprint of a particle: `taps` voxels per axis starting at base + first
+struct Footprint {
+    int base[3];
+    float weights[3][4];
+};
+
+int Taps(SplatKernel kernel) {
+    return kernel == SplatKernel::Trilinear ? 2 : 4;
+}
+
+int FirstTap(SplatKernel kernel) {
+    return kernel == SplatKernel::Trilinear ? 0 : -1;
+}
+
+void Weights(SplatKernel kernel, float f, float* w) {
+    if (kernel == SplatKernel::Trilinear) {
+        w[0] = 1.0f - f;
+        w[1] = f;
+        return;
+    }
+    // Uniform cubic B-spline at distances 1 + f, f, 1 - f, 2 - f
+    float f2 = f * f, f3 = f2 * f;
+    float g = 1.0f - f;
+    w[0] = g * g * g / 6.0f;
+    w[1] = (3.0f * f3 - 6.0f * f2 + 4.0f) / 6.0f;
+    w[2] = (-3.0f * f3 + 3.0f * f2 + 3.0f * f + 1.0f) / 6.0f;
+    w[3] = f3 / 6.0f;
+}
+
+// Brick range [lo, hi] touched by the particle on each axis; false if it
+// misses the grid entirely
+bool TouchedBricks(SplatKernel kernel, const Vector3Array& p, size_t i, const int dims[3], int lo[3], int hi[3]) {
+    const float coord[3] = { p.x[i], p.y[i], p.z[i] };
+    const int first = FirstTap(kernel), taps = Taps(kernel);
+    for (int a = 0; a < 3; ++a) {
+        if (!(coord[a] > -1e6f && coord[a] < 1e6f))
+            return false; // NaN or far away
+        int v0 = static_cast<int>(std::floor(coord[a])) + first;
+        int v1 = v0 + taps - 1;
+        v0 = std::max(v0, 0);
+        v1 = std::min(v1, dims[a] - 1);
+        if (v0 > v1)
+            return false;
+        lo[a] = v0 / brickSize;
+        hi[a] = v1 / brickSize;
+    }
+    return true;
+}
+
+}
+
+void ParticleSplatter::Splat(const Vector3Array& positions, size_t count, VoxelGrid<float>& grid) {
+    PROFILE_SCOPE("ParticleSplatter::Splat");
+    auto start = std::chrono::steady_clock::now();
+
+    const int dims[3] = { grid.Width(), grid.Height(), grid.Depth() };
+    const BrickMask layout(dims[0], dims[1], dims[2]);
+    const int bricks = layout.BrickCount();
+    const int bx = layout.BricksX(), by = layout.BricksY();
+    const SplatKernel k = kernel;
+
+    // A fixed number of particle chunks, each with its own histogram row
+    const int chunks = static_cast<int>(std::clamp<size_t>(count / 16384, 1, static_cast<size_t>(ParallelWorkerCount()) * 4));
+    const size_t chunkSize = (count + chunks - 1) / chunks;
+    histogram.assign(static_cast<size_t>(chunks) * bricks, 0);
+
+    auto forEachBrick = [&](size_t i, auto&& visit) {
+        int lo[3], hi[3];
+        if (!TouchedBricks(k, positions, i, dims, lo, hi))
+            return;
+        for (int z = lo[2]; z <= hi[2]; ++z)
+            for (int y = lo[1]; y <= hi[1]; ++y)
+                for (int x = lo[0]; x <= hi[0]; ++x)
+                    visit(x + bx * (y + by * z));
+    };
+
+    ParallelFor(chunks, [&](int c0, int c1) {
+        for (int c = c0; c < c1; ++c) {
+            uint32_t* row = &histogram[static_cast<size_t>(c) * bricks];
+            size_t end = std::min(count, (c + 1) * chunkSize);
+            for (size_t i = c * chunkSize; i < end; ++i)
+                forEachBrick(i, [&](int b) { row[b]++; });
+        }
+    }, 1);
+
+    // Brick-major exclusive scan, turning each histogram cell into the write
+    // cursor for that chunk's particles in that brick
+    binStart.resize(bricks + 1);
+    uint32_t total = 0;
+    for (int b = 0; b < bricks; ++b) {
+        binStart[b] = total;
+        for (int c = 0; c < chunks; ++c) {
+            uint32_t& cell = histogram[static_cast<size_t>(c) * bricks + b];
+            uint32_t n = cell;
+            cell = total;
+            total += n;
+        }
+    }
+    binStart[bricks] = total;
+    binned.resize(total);
+
+    ParallelFor(chunks, [&](int c0, int c1) {
+        for (int c = c0; c < c1; ++c) {
+            uint32_t* cursor = &histogram[static_cast<size_t>(c) * bricks];
+            size_t end = std::min(count, (c + 1) * chunkSize);
+            for (size_t i = c * chunkSize; i < end; ++i)
+                forEachBrick(i, [&](int b) { binned[cursor[b]++] = positions.Get(i); });
+        }
+    }, 1);
+
+    // Each brick owns its voxels: clear them, then add every particle binned here
+    const float mass = density;
+    const int first = FirstTap(k), taps = Taps(k);
+    ParallelFor(bricks, [&](int b0, int b1) {
+        for (int b = b0; b < b1; ++b) {
+            BrickRange r = layout.Bounds(b);
+            for (int z = r.z0; z < r.z1; ++z)
+                for (int y = r.y0; y < r.y1; ++y)
+                    std::fill(&grid.At(r.x0, y, z), &grid.At(r.x0, y, z) + (r.x1 - r.x0), 0.0f);
+
+            for (uint32_t n = binStart[b]; n < binStart[b + 1]; ++n) {
+                const float coord[3] = { binned[n].x, binned[n].y, binned[n].z };
+                Footprint fp;
+                for (int a = 0; a < 3; ++a) {
+                    float cell = std::floor(coord[a]);
+                    fp.base[a] = static_cast<int>(cell) + first;
+                    Weights(k, coord[a] - cell, fp.weights[a]);
+                }
+
+                // Clip the footprint to this brick
+                int x0 = std::max(fp.base[0], r.x0) - fp.base[0], x1 = std::min(fp.base[0] + taps, r.x1) - fp.base[0];
+                int y0 = std::max(fp.base[1], r.y0) - fp.base[1], y1 = std::min(fp.base[1] + taps, r.y1) - fp.base[1];
+                int z0 = std::max(fp.base[2], r.z0) - fp.base[2], z1 = std::min(fp.base[2] + taps, r.z1) - fp.base[2];
+                for (int tz = z0; tz < z1; ++tz)
+                    for (int ty = y0; ty < y1; ++ty) {
+                        float wyz = mass * fp.weights[2][tz] * fp.weights[1][ty];
+                        float* row = &grid.At(fp.base[0] + x0, fp.base[1] + ty, fp.base[2] + tz);
+                        for (int tx = x0; tx < x1; ++tx)
+                            row[tx - x0] += wyz * fp.weights[0][tx];
+                    }
+            }
+        }
+    });
+
+    int occupied = 0;
+    for (int b = 0; b < bricks; ++b)
+        occupied += binStart[b + 1] > binStart[b] ? 1 : 0;
+
+    stats.particles = count;
+    stats.binned = total;
+    stats.occupiedBricks = occupied;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
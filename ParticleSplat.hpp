@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Vector3Array.hpp"
+#include "VoxelGrid.hpp"
+
+enum class SplatKernel {
+    Trilinear,   // 2^3 voxels per particle, the inverse of VoxelGrid::Sample
+    CubicBSpline // 4^3 voxels per particle, smoother but 8x the writes
+};
+
+struct SplatStats {
+    double seconds = 0.0;
+    size_t particles = 0;
+    size_t binned = 0;    // Particle-brick pairs; above `particles` when kernels straddle bricks
+    int occupiedBricks = 0;
+};
+
+// Rasterizes particles into a density grid. Particles are first binned by
+// every brick their kernel touches (a parallel counting sort), then each
+// brick is zeroed and accumulated by one thread, clipping writes to its own
+// voxels. No two threads write the same voxel, so there are no atomics, and
+// each voxel sums its particles in index order, so the result does not
+// depend on the thread count.
+class ParticleSplatter {
+public:
+    SplatKernel kernel = SplatKernel::Trilinear;
+    float density = 1.0f; // Total added per particle
+
+    // Overwrites `grid` with the first `count` particles, in voxel coordinates.
+    void Splat(const Vector3Array& positions, size_t count, VoxelGrid<float>& grid);
+
+    const SplatStats& LastStats() const { return stats; }
+
+private:
+    std::vector<uint32_t> histogram; // Per chunk, per brick
+    std::vector<uint32_t> binStart;  // Per brick, plus the total
+    // Particle positions grouped by brick. Copied rather than indexed so the
+    // per-brick pass reads them sequentially instead of gathering
+    std::vector<Vector3> binned;
+
+    SplatStats stats;
+};
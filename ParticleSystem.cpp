@@ -0,0 +1,183 @@
+#include "ParticleSystem.hpp"
+#include "ParallelFor.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// Particles per ParallelFor item
+const int blockParticles = 4096;
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void SampleRange(const VelocityField& velocity, const Vector3Array& at, Vector3Array& out, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+        out.Set(i, velocity.Sample(at.Get(i)));
+}
+
+void CopyRange(const Vector3Array& from, Vector3Array& to, size_t begin, size_t end) {
+    std::copy(from.x.begin() + begin, from.x.begin() + end, to.x.begin() + begin);
+    std::copy(from.y.begin() + begin, from.y.begin() + end, to.y.begin() + begin);
+    std::copy(from.z.begin() + begin, from.z.begin() + end, to.z.begin() + begin);
+}
+
+bool Inside(const Vector3& p, const Vector3& boxMin, const Vector3& boxMax) {
+    return p.x >= boxMin.x && p.y >= boxMin.y && p.z >= boxMin.z && p.x <= boxMax.x && p.y <= boxMax.y && p.z <= boxMax.z;
+}
+
+}
+
+VelocityField VelocityField::Collocated(const SmokeFields& fields, float cellSize) {
+    VelocityField field;
+    field.u = &fields.u;
+    field.v = &fields.v;
+    field.w = &fields.w;
+    field.cellSize = cellSize;
+    return field;
+}
+
+Vector3 VelocityField::Sample(const Vector3& p) const {
+    const float scale = 1.0f / cellSize;
+    if (!staggered) {
+        // Same weights and corners for all three components
+        const int nx = u->Width(), ny = u->Height(), nz = u->Depth();
+        float x = std::clamp(p.x, 0.0f, nx - 1.0f), y = std::clamp(p.y, 0.0f, ny - 1.0f), z = std::clamp(p.z, 0.0f, nz - 1.0f);
+        int x0 = static_cast<int>(x), y0 = static_cast<int>(y), z0 = static_cast<int>(z);
+        float fx = x - x0, fy = y - y0, fz = z - z0;
+        size_t dx = x0 + 1 < nx ? 1 : 0;
+        size_t dy = y0 + 1 < ny ? nx : 0;
+        size_t dz = z0 + 1 < nz ? static_cast<size_t>(nx) * ny : 0;
+        size_t base = x0 + static_cast<size_t>(nx) * (y0 + static_cast<size_t>(ny) * z0);
+
+        auto lerp3 = [&](const float* g) {
+            const float* c = g + base;
+            float c00 = c[0] + (c[dx] - c[0]) * fx;
+            float c10 = c[dy] + (c[dy + dx] - c[dy]) * fx;
+            float c01 = c[dz] + (c[dz + dx] - c[dz]) * fx;
+            float c11 = c[dz + dy] + (c[dz + dy + dx] - c[dz + dy]) * fx;
+            float c0 = c00 + (c10 - c00) * fy;
+            float c1 = c01 + (c11 - c01) * fy;
+            return c0 + (c1 - c0) * fz;
+        };
+        return Vector3(lerp3(u->Data()), lerp3(v->Data()), lerp3(w->Data())) * scale;
+    }
+
+    // Face i of u sits at x = i - 0.5
+    return Vector3(u->Sample(p.x + 0.5f, p.y, p.z), v->Sample(p.x, p.y + 0.5f, p.z), w->Sample(p.x, p.y, p.z + 0.5f)) * scale;
+}
+
+ParticleSystem::ParticleSystem(size_t capacity, uint32_t seed)
+    : positions(capacity), ages(capacity), dead(capacity), stage(capacity), slope(capacity), sum(capacity), rng(seed) {}
+
+bool ParticleSystem::Add(const Vector3& position) {
+    if (count == Capacity())
+        return false;
+    positions.Set(count, position);
+    ages[count] = 0.0f;
+    count++;
+    return true;
+}
+
+void ParticleSystem::Clear() {
+    count = 0;
+    std::fill(emitCarry.begin(), emitCarry.end(), 0.0f);
+}
+
+void ParticleSystem::Step(const VelocityField& velocity, float dt) {
+    PROFILE_SCOPE("ParticleSystem::Step");
+    auto start = std::chrono::steady_clock::now();
+    stats.emitted = stats.killed = stats.dropped = 0;
+
+    Emit(dt);
+
+    auto advectStart = std::chrono::steady_clock::now();
+    Advect(velocity, dt);
+    stats.advectSeconds = SecondsSince(advectStart);
+
+    Compact();
+    stats.stepSeconds = SecondsSince(start);
+}
+
+void ParticleSystem::Emit(float dt) {
+    emitCarry.resize(emitters.size(), 0.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (size_t e = 0; e < emitters.size(); ++e) {
+        const ParticleEmitter& emitter = emitters[e];
+        float owed = emitCarry[e] + emitter.rate * dt;
+        size_t spawn = static_cast<size_t>(owed);
+        emitCarry[e] = owed - spawn;
+
+        Vector3 extent = emitter.boxMax - emitter.boxMin;
+        for (size_t i = 0; i < spawn; ++i) {
+            Vector3 p = emitter.boxMin + Vector3(extent.x * unit(rng), extent.y * unit(rng), extent.z * unit(rng));
+            if (!Add(p)) {
+                stats.dropped += spawn - i;
+                break;
+            }
+            stats.emitted++;
+        }
+    }
+}
+
+void ParticleSystem::Advect(const VelocityField& velocity, float dt) {
+    const Vector3 domainMax(velocity.Width() - 1.0f, velocity.Height() - 1.0f, velocity.Depth() - 1.0f);
+    const int blocks = static_cast<int>((count + blockParticles - 1) / blockParticles);
+
+    ParallelFor(blocks, [&](int first, int last) {
+        size_t begin = static_cast<size_t>(first) * blockParticles;
+        size_t end = std::min(count, static_cast<size_t>(last) * blockParticles);
+
+        // Velocity lookups are gathers, one particle at a time; the stage
+        // arithmetic runs through the batched SoA kernels
+        SampleRange(velocity, positions, slope, begin, end);
+        if (integrator == ParticleIntegrator::RK2) {
+            AddScaled(positions, slope, 0.5f * dt, stage, begin, end);
+            SampleRange(velocity, stage, slope, begin, end);
+            AddScaled(positions, slope, dt, positions, begin, end);
+        }
+        else {
+            CopyRange(slope, sum, begin, end);
+            AddScaled(positions, slope, 0.5f * dt, stage, begin, end);
+            SampleRange(velocity, stage, slope, begin, end);
+            AddScaled(sum, slope, 2.0f, sum, begin, end);
+            AddScaled(positions, slope, 0.5f * dt, stage, begin, end);
+            SampleRange(velocity, stage, slope, begin, end);
+            AddScaled(sum, slope, 2.0f, sum, begin, end);
+            AddScaled(positions, slope, dt, stage, begin, end);
+            SampleRange(velocity, stage, slope, begin, end);
+            AddScaled(sum, slope, 1.0f, sum, begin, end);
+            AddScaled(positions, sum, dt / 6.0f, positions, begin, end);
+        }
+
+        for (size_t i = begin; i < end; ++i) {
+            ages[i] += dt;
+            Vector3 p = positions.Get(i);
+            bool kill = !Inside(p, Vector3(), domainMax) || (lifetime > 0.0f && ages[i] > lifetime);
+            for (size_t k = 0; k < killers.size() && !kill; ++k)
+                kill = Inside(p, killers[k].boxMin, killers[k].boxMax);
+            dead[i] = kill ? 1 : 0;
+        }
+    });
+}
+
+void ParticleSystem::Compact() {
+    // Fill each hole with the last live particle: O(dead) moves, no
+    // allocation, and order does not matter for tracers
+    size_t i = 0;
+    while (i < count) {
+        if (!dead[i]) {
+            ++i;
+            continue;
+        }
+        stats.killed++;
+        --count;
+        positions.Set(i, positions.Get(count));
+        ages[i] = ages[count];
+        dead[i] = dead[count];
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "SmokeForces.hpp"
+#include "Vector3Array.hpp"
+#include "VoxelGrid.hpp"
+
+// Velocity to advect through, sampled trilinearly in voxel coordinates
+// (cell centres at integers). Collocated grids store every component at the
+// cell centre; staggered (MAC) grids store u on the x faces, so u is one
+// voxel wider than the domain, and likewise v and w. Collocated components
+// must share one size.
+struct VelocityField {
+    const VoxelGrid<float>* u = nullptr;
+    const VoxelGrid<float>* v = nullptr;
+    const VoxelGrid<float>* w = nullptr;
+    bool staggered = false;
+    float cellSize = 1.0f; // World units per voxel, velocities are world units/s
+
+    static VelocityField Collocated(const SmokeFields& fields, float cellSize = 1.0f);
+
+    int Width() const { return staggered ? u->Width() - 1 : u->Width(); }
+    int Height() const { return staggered ? v->Height() - 1 : v->Height(); }
+    int Depth() const { return staggered ? w->Depth() - 1 : w->Depth(); }
+
+    // Voxels per second at voxel position `p`.
+    Vector3 Sample(const Vector3& p) const;
+};
+
+enum class ParticleIntegrator { RK2, RK4 };
+
+// Spawns `rate` particles per second uniformly inside a voxel-space box.
+struct ParticleEmitter {
+    Vector3 boxMin, boxMax;
+    float rate = 1000.0f;
+};
+
+// Removes particles that enter a voxel-space box.
+struct ParticleKiller {
+    Vector3 boxMin, boxMax;
+};
+
+struct ParticleStats {
+    double stepSeconds = 0.0;
+    double advectSeconds = 0.0;
+    size_t emitted = 0;
+    size_t killed = 0;
+    size_t dropped = 0; // Emissions refused because the system was full
+};
+
+// Massless tracers carried by a velocity field. Positions live in a
+// structure-of-arrays sized to the capacity up front, so emitting, advecting
+// and compacting never reallocate. Particles also die when they leave the
+// domain or outlive `lifetime`.
+class ParticleSystem {
+public:
+    explicit ParticleSystem(size_t capacity, uint32_t seed = 1);
+
+    ParticleIntegrator integrator = ParticleIntegrator::RK2;
+    float lifetime = 0.0f; // Seconds, 0 for no limit
+    std::vector<ParticleEmitter> emitters;
+    std::vector<ParticleKiller> killers;
+
+    // Emits, advects by dt, then removes dead particles.
+    void Step(const VelocityField& velocity, float dt);
+
+    // Adds one particle if there is room; returns false when full.
+    bool Add(const Vector3& position);
+    void Clear();
+
+    size_t Count() const { return count; }
+    size_t Capacity() const { return positions.Size(); }
+
+    // Only the first Count() entries are live. Compaction moves particles,
+    // so an index does not identify the same particle across steps.
+    const Vector3Array& Positions() const { return positions; }
+    const std::vector<float>& Ages() const { return ages; }
+
+    const ParticleStats& LastStats() const { return stats; }
+
+private:
+    void Emit(float dt);
+    void Advect(const VelocityField& velocity, float dt);
+    void Compact();
+
+    size_t count = 0;
+    Vector3Array positions;
+    std::vector<float> ages;
+    std::vector<uint8_t> dead;
+
+    // RK stage scratch, same capacity as positions
+    Vector3Array stage, slope, sum;
+
+    std::vector<float> emitCarry; // Fractional particles owed per emitter
+    std::mt19937 rng;
+
+    ParticleStats stats;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+// Playback position in frames. Fractional positions lie between two stored
+// frames, so playback can run at any speed and be shown blended.
+class PlaybackClock {
+public:
+    void Reset(int frameCount) {
+        frames = frameCount;
+        position = 0.0;
+    }
+
+    void Seek(double frame) { position = std::clamp(frame, 0.0, Last()); }
+
+    // Moves by `delta` frames (negative plays backwards). Returns false if
+    // that ran past either end; the position is then clamped to it.
+    bool Advance(double delta) {
+        double next = position + delta;
+        position = std::clamp(next, 0.0, Last());
+        return next == position;
+    }
+
+    double Position() const { return position; }
+    int Frame() const { return static_cast<int>(std::floor(position)); }
+    float Fraction() const { return static_cast<float>(position - Frame()); }
+    double Last() const { return frames > 0 ? frames - 1.0 : 0.0; }
+
+private:
+    int frames = 0;
+    double position = 0.0;
+};
@@ -0,0 +1,171 @@
+#include "Profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct Event {
+    const char* name;
+    int64_t start;
+    int64_t end;
+};
+
+// Written only by its owning thread. `count` is published with release so
+// the exporter sees complete events without taking a lock.
+struct ThreadBuffer {
+    int id = 0;
+    std::string name;
+    std::vector<Event> events = std::vector<Event>(Profiler::ThreadCapacity);
+    std::atomic<int> count = 0;
+    std::atomic<uint32_t> epoch = 0;
+    bool retired = false; // Owning thread exited; guarded by registryMutex
+};
+
+std::atomic<bool> enabled = false;
+std::atomic<uint32_t> currentEpoch = 1;
+std::atomic<uint64_t> dropped = 0;
+
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+const auto origin = std::chrono::steady_clock::now();
+
+// Buffers outlive their threads so their events can still be exported; a
+// new thread takes over a retired buffer instead of growing the registry
+struct ThreadSlot {
+    ThreadBuffer* buffer = nullptr;
+
+    ThreadBuffer& Get() {
+        if (!buffer) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            for (auto& b : registry)
+                if (b->retired) {
+                    b->retired = false;
+                    buffer = b.get();
+                    break;
+                }
+            if (!buffer) {
+                registry.push_back(std::make_unique<ThreadBuffer>());
+                buffer = registry.back().get();
+                buffer->id = static_cast<int>(registry.size());
+            }
+        }
+        return *buffer;
+    }
+
+    ~ThreadSlot() {
+        if (buffer) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            buffer->retired = true;
+        }
+    }
+};
+
+thread_local ThreadSlot slot;
+
+void WriteEscaped(std::ofstream& out, const char* s) {
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\')
+            out << '\\';
+        out << *s;
+    }
+}
+
+}
+
+void Profiler::SetEnabled(bool on) {
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+bool Profiler::Enabled() {
+#if PROFILER_ENABLED
+    return enabled.load(std::memory_order_relaxed);
+#else
+    return false;
+#endif
+}
+
+void Profiler::SetThreadName(const char* name) {
+    ThreadBuffer& b = slot.Get();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    b.name = name;
+}
+
+void Profiler::Clear() {
+    // Writers notice the new epoch on their next event and start over
+    currentEpoch.fetch_add(1);
+    dropped = 0;
+}
+
+uint64_t Profiler::DroppedEvents() {
+    return dropped.load();
+}
+
+int64_t Profiler::NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Profiler::Record(const char* name, int64_t startNs, int64_t endNs) {
+    ThreadBuffer& b = slot.Get();
+
+    uint32_t epoch = currentEpoch.load(std::memory_order_acquire);
+    int n = b.count.load(std::memory_order_relaxed);
+    if (b.epoch.load(std::memory_order_relaxed) != epoch) {
+        b.count.store(0, std::memory_order_relaxed);
+        b.epoch.store(epoch, std::memory_order_release);
+        n = 0;
+    }
+    if (n >= ThreadCapacity) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    b.events[n] = { name, startNs, endNs };
+    b.count.store(n + 1, std::memory_order_release);
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out.is_open())
+        return false;
+
+    const uint32_t epoch = currentEpoch.load(std::memory_order_acquire);
+    bool first = true;
+    auto separator = [&]() {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    out << std::fixed;
+    out.precision(3); // Microseconds with nanosecond resolution
+    out << "{\"traceEvents\":[";
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (auto& b : registry) {
+        if (!b->name.empty()) {
+            separator();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->id << ",\"args\":{\"name\":\"";
+            WriteEscaped(out, b->name.c_str());
+            out << "\"}}";
+        }
+
+        // Events below `count` are never rewritten within an epoch
+        if (b->epoch.load(std::memory_order_acquire) != epoch)
+            continue;
+        int n = b->count.load(std::memory_order_acquire);
+        for (int i = 0; i < n; ++i) {
+            const Event& e = b->events[i];
+            separator();
+            out << "{\"name\":\"";
+            WriteEscaped(out, e.name);
+            out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->id
+                << ",\"ts\":" << e.start / 1000.0 << ",\"dur\":" << (e.end - e.start) / 1000.0 << "}";
+        }
+    }
+    out << "\n]}\n";
+    return out.good();
+}
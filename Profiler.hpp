@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Scoped CPU timers exported as Chrome trace-event JSON (chrome://tracing,
+// Perfetto). Each thread records into its own buffer without locking; the
+// only shared state touched per scope is the runtime on/off flag.
+//
+// Build with PROFILER_ENABLED=0 to compile every PROFILE_SCOPE away.
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+namespace Profiler {
+    // Events per thread between Clear() calls; later ones are dropped
+    const int ThreadCapacity = 1 << 16;
+
+    void SetEnabled(bool on);
+    bool Enabled();
+
+    // Labels the calling thread in exported traces.
+    void SetThreadName(const char* name);
+
+    // Discards everything recorded so far. Not safe to call concurrently
+    // with WriteChromeTrace.
+    void Clear();
+
+    // Writes all events recorded since the last Clear().
+    bool WriteChromeTrace(const std::string& path);
+
+    uint64_t DroppedEvents();
+
+    int64_t NowNs();
+    // `name` must outlive the profiler, e.g. a string literal.
+    void Record(const char* name, int64_t startNs, int64_t endNs);
+}
+
+// Times the enclosing scope if profiling was enabled when it began.
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name)
+        : name(Profiler::Enabled() ? name : nullptr), start(this->name ? Profiler::NowNs() : 0) {}
+
+    ~ProfileScope() {
+        if (name)
+            Profiler::Record(name, start, Profiler::NowNs());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    int64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILER_ENABLED
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
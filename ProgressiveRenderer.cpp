@@ -0,0 +1,147 @@
+#include "ProgressiveRenderer.hpp"
+#include "ParallelFor.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+int FloorPowerOfTwo(int n) {
+    int p = 1;
+    while (p * 2 <= n)
+        p *= 2;
+    return p;
+}
+
+// Bit-reversed index, so any prefix of the passes spreads its offsets evenly
+int ReverseBits(int i, int count) {
+    int r = 0;
+    for (int bit = 1; bit < count; bit <<= 1) {
+        r = (r << 1) | (i & 1);
+        i >>= 1;
+    }
+    return r;
+}
+
+// Bilinear upsample of a preview to the full image, matching the linear
+// sampler the shader path blits with. `channels` values per pixel.
+void Upsample(const float* src, int srcWidth, int srcHeight, float* dst, int dstWidth, int dstHeight, int channels) {
+    const float sx = static_cast<float>(srcWidth) / dstWidth;
+    const float sy = static_cast<float>(srcHeight) / dstHeight;
+    ParallelFor(dstHeight, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            float fy = std::clamp((y + 0.5f) * sy - 0.5f, 0.0f, srcHeight - 1.0f);
+            int iy = std::min(static_cast<int>(fy), std::max(srcHeight - 2, 0));
+            int iy1 = std::min(iy + 1, srcHeight - 1);
+            float wy = fy - iy;
+            for (int x = 0; x < dstWidth; ++x) {
+                float fx = std::clamp((x + 0.5f) * sx - 0.5f, 0.0f, srcWidth - 1.0f);
+                int ix = std::min(static_cast<int>(fx), std::max(srcWidth - 2, 0));
+                int ix1 = std::min(ix + 1, srcWidth - 1);
+                float wx = fx - ix;
+                const float* a = src + (static_cast<size_t>(iy) * srcWidth + ix) * channels;
+                const float* b = src + (static_cast<size_t>(iy) * srcWidth + ix1) * channels;
+                const float* c = src + (static_cast<size_t>(iy1) * srcWidth + ix) * channels;
+                const float* d = src + (static_cast<size_t>(iy1) * srcWidth + ix1) * channels;
+                float* out = dst + (static_cast<size_t>(y) * dstWidth + x) * channels;
+                for (int ch = 0; ch < channels; ++ch) {
+                    float top = a[ch] + (b[ch] - a[ch]) * wx;
+                    float bottom = c[ch] + (d[ch] - c[ch]) * wx;
+                    out[ch] = top + (bottom - top) * wy;
+                }
+            }
+        }
+    });
+}
+
+}
+
+int RefineSchedule::PassCount() const {
+    return FloorPowerOfTwo(std::max(passes, 1));
+}
+
+void RefineSchedule::Restart(bool interactive) {
+    preview = interactive;
+    next = 0;
+    total = interactive ? 1 + PassCount() : 1;
+}
+
+bool RefineSchedule::Next(RefinePass& pass) {
+    if (Converged())
+        return false;
+
+    const int n = PassCount();
+    pass = RefinePass(); // A single full-step pass unless previewing
+    if (preview && next == 0) {
+        pass.scale = std::max(previewScale, 1);
+        pass.stepScale = static_cast<float>(n);
+    }
+    else if (preview) {
+        int k = next - 1;
+        pass.stepScale = static_cast<float>(n);
+        pass.stepOffset = static_cast<float>(ReverseBits(k, n)) / n;
+        pass.weight = 1.0f / (k + 1);
+    }
+    next++;
+    return true;
+}
+
+void ProgressiveRenderer::Restart(bool interactive) {
+    schedule.Restart(interactive);
+    stats = ProgressiveStats();
+    elapsedSeconds = 0.0;
+}
+
+bool ProgressiveRenderer::Render(const VoxelGrid<float>& density, CpuImage& image) {
+    RefinePass p;
+    if (!schedule.Next(p))
+        return false;
+
+    PROFILE_SCOPE("ProgressiveRenderer::Render");
+    auto start = std::chrono::steady_clock::now();
+
+    renderer.settings = settings;
+    renderer.settings.stepSize = settings.stepSize * p.stepScale;
+    renderer.settings.stepOffset = p.stepOffset;
+    // Keep the cube's outline from the converged step rather than growing with the coarse one
+    if (settings.hitDistance <= 0.0f)
+        renderer.settings.hitDistance = settings.stepSize;
+
+    if (p.scale > 1) {
+        pass.Resize(std::max(image.width / p.scale, 1), std::max(image.height / p.scale, 1));
+        renderer.Render(density, pass);
+        image.depth.resize(image.rgba.size() / 4);
+        Upsample(pass.rgba.data(), pass.width, pass.height, image.rgba.data(), image.width, image.height, 4);
+        Upsample(pass.depth.data(), pass.width, pass.height, image.depth.data(), image.width, image.height, 1);
+    }
+    else {
+        pass.Resize(image.width, image.height);
+        renderer.Render(density, pass);
+        if (p.weight >= 1.0f) {
+            history.rgba = pass.rgba;
+            history.depth = pass.depth;
+        }
+        else {
+            // Running average of the refinement passes, depth included
+            const float w = p.weight;
+            for (size_t i = 0; i < history.rgba.size(); ++i)
+                history.rgba[i] += (pass.rgba[i] - history.rgba[i]) * w;
+            for (size_t i = 0; i < history.depth.size(); ++i)
+                history.depth[i] += (pass.depth[i] - history.depth[i]) * w;
+        }
+        history.width = image.width;
+        history.height = image.height;
+        image.rgba = history.rgba;
+        image.depth = history.depth;
+    }
+
+    elapsedSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.passes = schedule.Completed();
+    stats.converged = schedule.Converged();
+    if (stats.passes == 1)
+        stats.firstImageSeconds = elapsedSeconds;
+    if (stats.converged)
+        stats.convergedSeconds = elapsedSeconds;
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CpuRenderer.hpp"
+
+// One pass of a progressive render.
+struct RefinePass {
+    int scale = 1;           // Resolution divisor per axis; above 1 for the preview
+    float stepScale = 1.0f;  // Multiple of the base step size marched this pass
+    float stepOffset = 0.0f; // Start offset as a fraction of the pass's step
+    float weight = 1.0f;     // Blend weight into the history; 1 replaces it
+};
+
+// Order of passes shared by ProgressiveRenderer and the shader path in Game.
+// An interactive restart (camera motion) starts with a low-resolution,
+// coarse-step preview, then marches full-resolution passes at `passes` times
+// the base step, each starting at a different fraction of that step. Their
+// running average ends up sampling every base step once. With Classic
+// shading below saturation that is exactly a single full-step march; the
+// transfer-function modes composite non-linearly, so there it is the average
+// of the offset coarse marches, close to but not equal to a full-step one.
+// Other restarts, such as a new simulation frame, draw one full-step pass.
+class RefineSchedule {
+public:
+    int previewScale = 4;
+    int passes = 8; // Rounded down to a power of two
+
+    void Restart(bool interactive);
+    // Next pass to draw; false once converged.
+    bool Next(RefinePass& pass);
+
+    bool Converged() const { return next >= total; }
+    int Completed() const { return next; }
+    int Total() const { return total; }
+
+private:
+    int PassCount() const;
+
+    bool preview = false;
+    int next = 0, total = 0;
+};
+
+struct ProgressiveStats {
+    int passes = 0;                 // Since the last restart
+    bool converged = false;
+    double firstImageSeconds = 0.0; // Render time from the restart to the first image
+    double convergedSeconds = 0.0;  // ... and to the converged one
+};
+
+// CpuRenderer driven by a RefineSchedule. Each Render() call draws one pass
+// and leaves the current estimate in the image; once converged it returns
+// without marching.
+class ProgressiveRenderer {
+public:
+    CpuRenderSettings settings; // stepSize is the converged step
+    RefineSchedule schedule;
+
+    // Call when the camera or scene changes; `interactive` asks for a preview first.
+    void Restart(bool interactive);
+    // Draws the next pass into `image`; false if already converged.
+    bool Render(const VoxelGrid<float>& density, CpuImage& image);
+
+    const ProgressiveStats& Stats() const { return stats; }
+
+private:
+    CpuRenderer renderer;
+    CpuImage pass;
+    CpuImage history;
+
+    ProgressiveStats stats;
+    double elapsedSeconds = 0.0;
+};
@@ -0,0 +1,157 @@
+#include "SdfBake.hpp"
+#include "ParallelFor.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const int brickSize = 8;
+
+}
+
+void SdfBaker::Bake(const SdfScene& scene, const Vector3& boxMin, const Vector3& boxMax, VoxelGrid<float>& field) {
+    PROFILE_SCOPE("SdfBaker::Bake");
+    auto start = std::chrono::steady_clock::now();
+
+    const int X = field.Width(), Y = field.Height(), Z = field.Depth();
+    const size_t count = field.Size();
+    const Vector3 extent = boxMax - boxMin;
+    const Vector3 cell(extent.x / X, extent.y / Y, extent.z / Z);
+    const float voxel = std::max(cell.x, std::max(cell.y, cell.z));
+    const float band = settings.band * voxel;
+    const float inf = std::numeric_limits<float>::infinity();
+    auto centre = [&](int i, int j, int k) {
+        return Vector3(boxMin.x + (i + 0.5f) * cell.x, boxMin.y + (j + 0.5f) * cell.y, boxMin.z + (k + 0.5f) * cell.z);
+    };
+    auto index = [&](int i, int j, int k) {
+        return static_cast<size_t>(i) + static_cast<size_t>(X) * (j + static_cast<size_t>(Y) * k);
+    };
+
+    closest.resize(count);
+    seed.resize(count);
+    nearest.resize(count);
+    float* out = field.Data();
+
+    // Scene queries, against the objects gathered once per brick. Any voxel
+    // inside a solid is evaluated, so the ones left unknown (infinity) are
+    // all outside the band
+    const int bricksX = (X + brickSize - 1) / brickSize, bricksY = (Y + brickSize - 1) / brickSize;
+    const int bricksZ = (Z + brickSize - 1) / brickSize;
+    std::atomic<int> evaluated = 0;
+    ParallelFor(bricksX * bricksY * bricksZ, [&](int begin, int end) {
+        int localEvaluated = 0;
+        std::vector<int> candidates;
+        for (int b = begin; b < end; ++b) {
+            const int x0 = (b % bricksX) * brickSize, y0 = (b / bricksX % bricksY) * brickSize, z0 = (b / (bricksX * bricksY)) * brickSize;
+            const int x1 = std::min(x0 + brickSize, X), y1 = std::min(y0 + brickSize, Y), z1 = std::min(z0 + brickSize, Z);
+
+            // Every voxel centre of the brick lies within `radius` of its middle
+            const Vector3 first = centre(x0, y0, z0), last = centre(x1 - 1, y1 - 1, z1 - 1);
+            scene.Gather((first + last) * 0.5f, (last - first).magnitude() * 0.5f, band, candidates);
+
+            for (int k = z0; k < z1; ++k)
+                for (int j = y0; j < y1; ++j)
+                    for (int i = x0; i < x1; ++i) {
+                        const size_t v = index(i, j, k);
+                        seed[v] = 0;
+                        if (candidates.empty()) {
+                            out[v] = inf;
+                            continue;
+                        }
+                        const Vector3 p = centre(i, j, k);
+                        const float d = scene.Distance(p, candidates);
+                        localEvaluated++;
+                        if (d >= band) {
+                            out[v] = inf;
+                            continue;
+                        }
+                        out[v] = d;
+                        if (d > -band) {
+                            closest[v] = p - scene.Normal(p, candidates, voxel * 0.25f) * d;
+                            seed[v] = 1;
+                        }
+                    }
+        }
+        evaluated += localEvaluated;
+    });
+
+    // Seeds packed together, so the sweeps read them from cache
+    seedPoints.clear();
+    for (size_t i = 0; i < count; ++i) {
+        nearest[i] = seed[i] ? static_cast<int>(seedPoints.size()) : -1;
+        if (seed[i])
+            seedPoints.push_back(closest[i]);
+    }
+
+    // Closest-point sweeps: every voxel in turn offers its nearest surface
+    // point to the next one along a line, forwards and then backwards along
+    // x, y and z. One round carries each point along x, then y, then z; a
+    // second catches most voxels whose nearest point needs another turn.
+    // Lines are independent, so each sweep splits across workers by slab.
+    auto offer = [&](size_t to, size_t from, const Vector3& p) {
+        const int s = nearest[from], best = nearest[to];
+        if (s < 0 || s == best)
+            return;
+        Vector3 d = seedPoints[s] - p;
+        if (best >= 0) {
+            Vector3 current = seedPoints[best] - p;
+            if (current.dot(current) <= d.dot(d))
+                return;
+        }
+        nearest[to] = s;
+    };
+    for (int round = 0; round < settings.rounds; ++round) {
+        ParallelFor(Z, [&](int k0, int k1) {
+            for (int k = k0; k < k1; ++k)
+                for (int j = 0; j < Y; ++j) {
+                    for (int i = 1; i < X; ++i)
+                        offer(index(i, j, k), index(i - 1, j, k), centre(i, j, k));
+                    for (int i = X - 2; i >= 0; --i)
+                        offer(index(i, j, k), index(i + 1, j, k), centre(i, j, k));
+                }
+        });
+        ParallelFor(Z, [&](int k0, int k1) {
+            for (int k = k0; k < k1; ++k) {
+                for (int j = 1; j < Y; ++j)
+                    for (int i = 0; i < X; ++i)
+                        offer(index(i, j, k), index(i, j - 1, k), centre(i, j, k));
+                for (int j = Y - 2; j >= 0; --j)
+                    for (int i = 0; i < X; ++i)
+                        offer(index(i, j, k), index(i, j + 1, k), centre(i, j, k));
+            }
+        });
+        ParallelFor(Y, [&](int j0, int j1) {
+            for (int j = j0; j < j1; ++j) {
+                for (int k = 1; k < Z; ++k)
+                    for (int i = 0; i < X; ++i)
+                        offer(index(i, j, k), index(i, j, k - 1), centre(i, j, k));
+                for (int k = Z - 2; k >= 0; --k)
+                    for (int i = 0; i < X; ++i)
+                        offer(index(i, j, k), index(i, j, k + 1), centre(i, j, k));
+            }
+        });
+    }
+
+    // Unknown voxels take the swept distance, which cannot be inside the band
+    const float none = extent.magnitude();
+    ParallelFor(Z, [&](int k0, int k1) {
+        for (int k = k0; k < k1; ++k)
+            for (int j = 0; j < Y; ++j)
+                for (int i = 0; i < X; ++i) {
+                    const size_t v = index(i, j, k);
+                    if (std::isfinite(out[v]))
+                        continue;
+                    const int s = nearest[v];
+                    out[v] = s >= 0 ? std::max((seedPoints[s] - centre(i, j, k)).magnitude(), band) : none;
+                }
+    });
+
+    stats.evaluated = evaluated;
+    stats.seeds = static_cast<int>(seedPoints.size());
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
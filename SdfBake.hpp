@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "SdfScene.hpp"
+#include "Vector3.hpp"
+#include "VoxelGrid.hpp"
+
+struct SdfBakeSettings {
+    float band = 1.5f; // Half width of the exactly evaluated shell around surfaces, in voxels
+    int rounds = 2;    // Closest-point sweeps over all three axes
+};
+
+struct SdfBakeStats {
+    double seconds = 0.0;
+    int evaluated = 0; // Voxels whose distance came from the scene
+    int seeds = 0;     // Voxels within the band, which seed the sweeps
+};
+
+// Bakes an SdfScene into a signed distance grid spanning boxMin..boxMax of
+// the scene's space, with voxel centres placed as the renderer samples them.
+//
+// Each 8^3 brick gathers the few objects that can come within the band of
+// it; bricks with none are not evaluated at all. Other voxels evaluate just
+// those objects, and the ones within the band record their nearest surface
+// point. Every voxel inside a solid is among those evaluated, so the rest are
+// outside, and sweeps along each axis carry the nearest surface points out
+// to them in a few passes over the grid however far the surfaces are. All
+// stages run across ParallelFor workers.
+//
+// Values are world-space distances: exact within the band and wherever the
+// scene was evaluated, and elsewhere the distance to the nearest surface
+// point found in the band, which only sees surfaces inside the box.
+class SdfBaker {
+public:
+    SdfBakeSettings settings;
+
+    // Fills `field`, keeping its size.
+    void Bake(const SdfScene& scene, const Vector3& boxMin, const Vector3& boxMax, VoxelGrid<float>& field);
+
+    const SdfBakeStats& LastStats() const { return stats; }
+
+private:
+    std::vector<Vector3> closest;    // Per voxel, the surface point found from it, if a seed
+    std::vector<uint8_t> seed;       // Per voxel, 1 if within the band
+    std::vector<Vector3> seedPoints; // Surface points of the seeds, in voxel order
+    std::vector<int> nearest;        // Per voxel, the seed with the nearest surface point so far, -1 if none
+
+    SdfBakeStats stats;
+};
@@ -0,0 +1,327 @@
+#include "SdfScene.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int leafObjects = 2;
+
+// Local to world rotation of Euler angles about x, then y, then z, row-major
+void EulerMatrix(const Vector3& angles, float m[9]) {
+    float cx = std::cos(angles.x), sx = std::sin(angles.x);
+    float cy = std::cos(angles.y), sy = std::sin(angles.y);
+    float cz = std::cos(angles.z), sz = std::sin(angles.z);
+    // Rz * Ry * Rx
+    m[0] = cz * cy; m[1] = cz * sy * sx - sz * cx; m[2] = cz * sy * cx + sz * sx;
+    m[3] = sz * cy; m[4] = sz * sy * sx + cz * cx; m[5] = sz * sy * cx - cz * sx;
+    m[6] = -sy;     m[7] = cy * sx;                m[8] = cy * cx;
+}
+
+void Multiply(const float a[9], const float b[9], float out[9]) {
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c)
+            out[r * 3 + c] = a[r * 3] * b[c] + a[r * 3 + 1] * b[3 + c] + a[r * 3 + 2] * b[6 + c];
+}
+
+Vector3 Apply(const float m[9], const Vector3& v) {
+    return Vector3(m[0] * v.x + m[1] * v.y + m[2] * v.z, m[3] * v.x + m[4] * v.y + m[5] * v.z,
+        m[6] * v.x + m[7] * v.y + m[8] * v.z);
+}
+
+float BoxSDF(const Vector3& p, const Vector3& size) {
+    Vector3 d(std::abs(p.x) - size.x, std::abs(p.y) - size.y, std::abs(p.z) - size.z);
+    Vector3 outside(std::max(d.x, 0.0f), std::max(d.y, 0.0f), std::max(d.z, 0.0f));
+    return outside.magnitude() + std::min(std::max(d.x, std::max(d.y, d.z)), 0.0f);
+}
+
+float CapsuleSDF(Vector3 p, float radius, float halfLength) {
+    p.y -= std::clamp(p.y, -halfLength, halfLength);
+    return p.magnitude() - radius;
+}
+
+// Polynomial smooth minimum; at most k / 4 below the hard one
+float SmoothMin(float a, float b, float k) {
+    float h = std::max(k - std::abs(a - b), 0.0f) / k;
+    return std::min(a, b) - h * h * k * 0.25f;
+}
+
+// Signed distance to an axis-aligned box. A shape inside the box can be no
+// nearer than the box itself, and no deeper inside either, so this bounds
+// its distance from below wherever the point is.
+float BoundsDistance(const Vector3& p, const Vector3& boundsMin, const Vector3& boundsMax) {
+    Vector3 centre = (boundsMin + boundsMax) * 0.5f;
+    return BoxSDF(p - centre, (boundsMax - boundsMin) * 0.5f);
+}
+
+// Tetrahedron of samples: four lookups instead of six central differences
+template <typename Sdf>
+Vector3 Gradient(const Sdf& sdf, const Vector3& p, float epsilon) {
+    const Vector3 k0(1.0f, -1.0f, -1.0f), k1(-1.0f, -1.0f, 1.0f), k2(-1.0f, 1.0f, -1.0f), k3(1.0f, 1.0f, 1.0f);
+    Vector3 n = k0 * sdf(p + k0 * epsilon) + k1 * sdf(p + k1 * epsilon) + k2 * sdf(p + k2 * epsilon) + k3 * sdf(p + k3 * epsilon);
+    return n.normalized();
+}
+
+Vector3 Min(const Vector3& a, const Vector3& b) {
+    return Vector3(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+}
+
+Vector3 Max(const Vector3& a, const Vector3& b) {
+    return Vector3(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+}
+
+}
+
+void SdfScene::Build() {
+    primitives.clear();
+    compiled.clear();
+    order.clear();
+    nodes.clear();
+
+    const float inf = std::numeric_limits<float>::infinity();
+    for (size_t o = 0; o < objects.size(); ++o) {
+        const SdfObject& object = objects[o];
+        if (object.primitives.empty())
+            continue;
+
+        float objectRotation[9];
+        EulerMatrix(object.transform.rotation, objectRotation);
+        const float objectScale = object.transform.scale;
+
+        CompiledObject c;
+        c.source = static_cast<int>(o);
+        c.first = static_cast<int>(primitives.size());
+        c.count = static_cast<int>(object.primitives.size());
+        c.boundsMin = Vector3(inf, inf, inf);
+        c.boundsMax = Vector3(-inf, -inf, -inf);
+        float margin = 0.0f;
+
+        for (size_t i = 0; i < object.primitives.size(); ++i) {
+            const SdfPrimitive& prim = object.primitives[i];
+            CompiledPrimitive cp;
+            cp.shape = prim.shape;
+            cp.op = i == 0 ? SdfOp::Union : prim.op;
+            cp.size = prim.size;
+            cp.scale = objectScale * prim.transform.scale;
+            cp.blend = prim.blend * objectScale;
+            cp.position = object.transform.position + Apply(objectRotation, prim.transform.position * objectScale);
+
+            float primRotation[9], toWorld[9];
+            EulerMatrix(prim.transform.rotation, primRotation);
+            Multiply(objectRotation, primRotation, toWorld);
+            for (int r = 0; r < 3; ++r)
+                for (int col = 0; col < 3; ++col)
+                    cp.rotation[r * 3 + col] = toWorld[col * 3 + r];
+            primitives.push_back(cp);
+
+            // Subtracting or intersecting never grows the shape, except for
+            // the smoothing, which can pull the surface out by a quarter of it
+            margin = std::max(margin, cp.blend * 0.25f);
+            if (cp.op != SdfOp::Union)
+                continue;
+            Vector3 local = prim.size;
+            if (prim.shape == SdfShape::Sphere)
+                local = Vector3(prim.size.x, prim.size.x, prim.size.x);
+            else if (prim.shape == SdfShape::Capsule)
+                local = Vector3(prim.size.x, prim.size.y + prim.size.x, prim.size.x);
+            Vector3 half(
+                (std::abs(toWorld[0]) * local.x + std::abs(toWorld[1]) * local.y + std::abs(toWorld[2]) * local.z) * cp.scale,
+                (std::abs(toWorld[3]) * local.x + std::abs(toWorld[4]) * local.y + std::abs(toWorld[5]) * local.z) * cp.scale,
+                (std::abs(toWorld[6]) * local.x + std::abs(toWorld[7]) * local.y + std::abs(toWorld[8]) * local.z) * cp.scale);
+            c.boundsMin = Min(c.boundsMin, cp.position - half);
+            c.boundsMax = Max(c.boundsMax, cp.position + half);
+        }
+        c.boundsMin -= Vector3(margin, margin, margin);
+        c.boundsMax += Vector3(margin, margin, margin);
+        compiled.push_back(c);
+    }
+
+    if (compiled.empty())
+        return;
+    order.resize(compiled.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = static_cast<int>(i);
+    nodes.reserve(compiled.size() * 2);
+    nodes.push_back(Node());
+    BuildNode(0, 0, static_cast<int>(order.size()));
+}
+
+// Median split along the longest axis of the object centres
+void SdfScene::BuildNode(int node, int begin, int end) {
+    const float inf = std::numeric_limits<float>::infinity();
+    Vector3 boundsMin(inf, inf, inf), boundsMax(-inf, -inf, -inf);
+    Vector3 centreMin(inf, inf, inf), centreMax(-inf, -inf, -inf);
+    for (int i = begin; i < end; ++i) {
+        const CompiledObject& c = compiled[order[i]];
+        boundsMin = Min(boundsMin, c.boundsMin);
+        boundsMax = Max(boundsMax, c.boundsMax);
+        Vector3 centre = (c.boundsMin + c.boundsMax) * 0.5f;
+        centreMin = Min(centreMin, centre);
+        centreMax = Max(centreMax, centre);
+    }
+    nodes[node].boundsMin = boundsMin;
+    nodes[node].boundsMax = boundsMax;
+
+    if (end - begin <= leafObjects) {
+        nodes[node].first = begin;
+        nodes[node].count = end - begin;
+        return;
+    }
+
+    Vector3 extent = centreMax - centreMin;
+    int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+    auto centre = [&](int object) {
+        const CompiledObject& c = compiled[object];
+        return axis == 0 ? c.boundsMin.x + c.boundsMax.x : axis == 1 ? c.boundsMin.y + c.boundsMax.y : c.boundsMin.z + c.boundsMax.z;
+    };
+    int middle = (begin + end) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+        [&](int a, int b) { return centre(a) < centre(b); });
+
+    const int children = static_cast<int>(nodes.size());
+    nodes[node].first = children;
+    nodes[node].count = 0;
+    nodes.push_back(Node());
+    nodes.push_back(Node());
+    BuildNode(children, begin, middle);
+    BuildNode(children + 1, middle, end);
+}
+
+float SdfScene::ObjectDistance(int object, const Vector3& p) const {
+    const CompiledObject& c = compiled[object];
+    float d = 0.0f;
+    for (int i = c.first; i < c.first + c.count; ++i) {
+        const CompiledPrimitive& prim = primitives[i];
+        Vector3 local = Apply(prim.rotation, p - prim.position) / prim.scale;
+        float di;
+        if (prim.shape == SdfShape::Box)
+            di = BoxSDF(local, prim.size);
+        else if (prim.shape == SdfShape::Sphere)
+            di = local.magnitude() - prim.size.x;
+        else
+            di = CapsuleSDF(local, prim.size.x, prim.size.y);
+        di *= prim.scale;
+
+        if (i == c.first) {
+            d = di;
+            continue;
+        }
+        const float k = prim.blend;
+        if (prim.op == SdfOp::Union)
+            d = k > 0.0f ? SmoothMin(d, di, k) : std::min(d, di);
+        else if (prim.op == SdfOp::Subtract)
+            d = k > 0.0f ? -SmoothMin(-d, di, k) : std::max(d, -di);
+        else
+            d = k > 0.0f ? -SmoothMin(-d, -di, k) : std::max(d, di);
+    }
+    return d;
+}
+
+float SdfScene::Distance(const Vector3& p, float limit, SdfQuery* query) const {
+    float best = limit;
+    int nearest = -1, evaluated = 0;
+
+    if (!nodes.empty()) {
+        // Nodes waiting to be visited, with their box distance at push time
+        struct Entry {
+            int node;
+            float distance;
+        };
+        Entry stack[64];
+        int top = 0;
+        stack[top++] = { 0, BoundsDistance(p, nodes[0].boundsMin, nodes[0].boundsMax) };
+
+        while (top > 0) {
+            const Entry e = stack[--top];
+            if (e.distance >= best)
+                continue;
+            const Node& n = nodes[e.node];
+            if (n.count > 0) {
+                for (int i = n.first; i < n.first + n.count; ++i) {
+                    int object = order[i];
+                    float d = ObjectDistance(object, p);
+                    evaluated += compiled[object].count;
+                    if (d < best) {
+                        best = d;
+                        nearest = object;
+                    }
+                }
+                continue;
+            }
+
+            // Nearer child on top so it is visited first
+            Entry a = { n.first, BoundsDistance(p, nodes[n.first].boundsMin, nodes[n.first].boundsMax) };
+            Entry b = { n.first + 1, BoundsDistance(p, nodes[n.first + 1].boundsMin, nodes[n.first + 1].boundsMax) };
+            if (a.distance < b.distance)
+                std::swap(a, b);
+            if (a.distance < best)
+                stack[top++] = a;
+            if (b.distance < best)
+                stack[top++] = b;
+        }
+    }
+
+    if (query) {
+        query->object = nearest >= 0 ? compiled[nearest].source : -1;
+        query->primitives = evaluated;
+    }
+    return best;
+}
+
+float SdfScene::DistanceBruteForce(const Vector3& p, SdfQuery* query) const {
+    float best = std::numeric_limits<float>::infinity();
+    int nearest = -1, evaluated = 0;
+    for (int object = 0; object < static_cast<int>(compiled.size()); ++object) {
+        float d = ObjectDistance(object, p);
+        evaluated += compiled[object].count;
+        if (d < best) {
+            best = d;
+            nearest = object;
+        }
+    }
+    if (query) {
+        query->object = nearest >= 0 ? compiled[nearest].source : -1;
+        query->primitives = evaluated;
+    }
+    return best;
+}
+
+Vector3 SdfScene::Normal(const Vector3& p, float epsilon) const {
+    return Gradient([&](const Vector3& q) { return Distance(q); }, p, epsilon);
+}
+
+void SdfScene::Gather(const Vector3& centre, float radius, float limit, std::vector<int>& candidates) const {
+    candidates.clear();
+    if (nodes.empty())
+        return;
+    const float reach = limit + radius;
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& n = nodes[stack[--top]];
+        if (BoundsDistance(centre, n.boundsMin, n.boundsMax) >= reach)
+            continue;
+        if (n.count > 0) {
+            for (int i = n.first; i < n.first + n.count; ++i) {
+                const CompiledObject& c = compiled[order[i]];
+                if (BoundsDistance(centre, c.boundsMin, c.boundsMax) < reach)
+                    candidates.push_back(order[i]);
+            }
+            continue;
+        }
+        stack[top++] = n.first;
+        stack[top++] = n.first + 1;
+    }
+}
+
+float SdfScene::Distance(const Vector3& p, const std::vector<int>& candidates) const {
+    float best = std::numeric_limits<float>::infinity();
+    for (int object : candidates)
+        best = std::min(best, ObjectDistance(object, p));
+    return best;
+}
+
+Vector3 SdfScene::Normal(const Vector3& p, const std::vector<int>& candidates, float epsilon) const {
+    return Gradient([&](const Vector3& q) { return Distance(q, candidates); }, p, epsilon);
+}
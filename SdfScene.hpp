@@ -0,0 +1,110 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+#include "Vector3.hpp"
+
+enum class SdfShape {
+    Box,     // Half extents in `size`
+    Sphere,  // Radius in size.x
+    Capsule  // Radius in size.x around a segment along local y of half length size.y
+};
+
+// How a primitive combines with the shape built so far in its object.
+enum class SdfOp {
+    Union,
+    Subtract, // Carves the primitive out
+    Intersect
+};
+
+// Rotation, uniform scale and translation, applied in that order.
+// Non-uniform scale would stop the distances from being exact, so there is none.
+struct SdfTransform {
+    Vector3 position;
+    Vector3 rotation; // Euler angles in radians, about x, then y, then z
+    float scale = 1.0f;
+};
+
+struct SdfPrimitive {
+    SdfShape shape = SdfShape::Box;
+    Vector3 size = Vector3(0.5f, 0.5f, 0.5f);
+    SdfTransform transform; // Within the object
+    SdfOp op = SdfOp::Union; // Ignored on an object's first primitive
+    float blend = 0.0f;      // Smoothing radius of the op in object units; 0 keeps a sharp edge
+};
+
+// A CSG chain: the first primitive, then each following one combined with
+// the result so far by its op. Objects are unioned into the scene.
+struct SdfObject {
+    std::vector<SdfPrimitive> primitives;
+    SdfTransform transform;
+    Vector3 color = Vector3(0.6f, 0.6f, 0.6f);
+};
+
+struct SdfQuery {
+    int object = -1;    // Nearest object found, -1 if none within the limit
+    int primitives = 0; // Primitive distances evaluated, for profiling
+};
+
+// Signed distance field of many objects with a bounding volume hierarchy
+// over them. A query visits nodes nearest first and skips any whose box is
+// further than the closest surface found so far, so a point only evaluates
+// the objects around it. Queries are const and safe to run from several
+// threads at once.
+class SdfScene {
+public:
+    std::vector<SdfObject> objects;
+
+    // Flattens the transforms and rebuilds the hierarchy; call after editing `objects`.
+    void Build();
+
+    // Distance to the nearest surface, negative inside. Exact below `limit`;
+    // past it the result is `limit` or more and only bounds the distance from
+    // below, which is all a hit test or a sphere-tracing step needs.
+    float Distance(const Vector3& p, float limit = std::numeric_limits<float>::infinity(), SdfQuery* query = nullptr) const;
+    // The same distance without the hierarchy, for comparison.
+    float DistanceBruteForce(const Vector3& p, SdfQuery* query = nullptr) const;
+    // Unit gradient of the distance by finite differences.
+    Vector3 Normal(const Vector3& p, float epsilon = 1e-3f) const;
+
+    // For many queries close together: the objects that can come nearer
+    // than `limit` to any point within `radius` of `centre`. Distance() and
+    // Normal() over the list then match the full queries below the limit
+    // everywhere in that sphere, without walking the hierarchy each time.
+    void Gather(const Vector3& centre, float radius, float limit, std::vector<int>& candidates) const;
+    float Distance(const Vector3& p, const std::vector<int>& candidates) const;
+    Vector3 Normal(const Vector3& p, const std::vector<int>& candidates, float epsilon) const;
+
+    bool Empty() const { return compiled.empty(); }
+    int NodeCount() const { return static_cast<int>(nodes.size()); }
+
+private:
+    // A primitive with its object's transform folded in: world to local is
+    // rotate(p - position) / scale, and local distances scale back up.
+    struct CompiledPrimitive {
+        SdfShape shape;
+        SdfOp op;
+        Vector3 size;
+        Vector3 position;
+        float rotation[9]; // World to local, row-major
+        float scale;
+        float blend;       // World units
+    };
+    struct CompiledObject {
+        int source;       // Index in `objects`
+        int first, count; // Into `primitives`
+        Vector3 boundsMin, boundsMax;
+    };
+    struct Node {
+        Vector3 boundsMin, boundsMax;
+        int first, count; // Leaf: range of `order`; inner: count 0 and children first, first + 1
+    };
+
+    float ObjectDistance(int object, const Vector3& p) const;
+    void BuildNode(int node, int begin, int end);
+
+    std::vector<CompiledPrimitive> primitives;
+    std::vector<CompiledObject> compiled;
+    std::vector<int> order; // Objects in leaf order
+    std::vector<Node> nodes;
+};
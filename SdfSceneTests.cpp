@@ -0,0 +1,99 @@
+#include "SdfScene.hpp"
+#include "Tests.hpp"
+
+#include <random>
+
+namespace {
+
+// Random objects over the unit box: rotated and scaled, with carved,
+// intersected and blended primitives among them
+SdfScene RandomScene(int count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto random = [&]() { return Vector3(unit(rng), unit(rng), unit(rng)); };
+
+    SdfScene scene;
+    for (int i = 0; i < count; ++i) {
+        SdfObject object;
+        object.transform.position = random() * 2.0f - Vector3(1.0f, 1.0f, 1.0f);
+        object.transform.rotation = random() * 6.2831853f;
+        object.transform.scale = 0.5f + unit(rng);
+        for (int k = 0; k < 1 + i % 3; ++k) {
+            SdfPrimitive primitive;
+            primitive.shape = static_cast<SdfShape>((i + k) % 3);
+            primitive.size = random() * 0.05f + Vector3(0.01f, 0.01f, 0.01f);
+            primitive.transform.position = (random() - Vector3(0.5f, 0.5f, 0.5f)) * 0.05f;
+            primitive.transform.rotation = random() * 6.2831853f;
+            primitive.op = static_cast<SdfOp>((i + k) % 3);
+            primitive.blend = k % 2 ? 0.01f : 0.0f;
+            object.primitives.push_back(primitive);
+        }
+        scene.objects.push_back(object);
+    }
+    scene.Build();
+    return scene;
+}
+
+std::vector<Vector3> RandomPoints(int count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(-1.2f, 1.2f);
+    std::vector<Vector3> points(count);
+    for (Vector3& p : points)
+        p = Vector3(unit(rng), unit(rng), unit(rng));
+    return points;
+}
+
+}
+
+TEST(SdfSceneMatchesBruteForce) {
+    const SdfScene scene = RandomScene(300, 1);
+    int mismatches = 0;
+    for (const Vector3& p : RandomPoints(20000, 2)) {
+        SdfQuery bvh, brute;
+        if (scene.Distance(p, std::numeric_limits<float>::infinity(), &bvh) != scene.DistanceBruteForce(p, &brute)
+            || bvh.object != brute.object)
+            mismatches++;
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST(SdfSceneLimitedDistance) {
+    // Exact below the limit, at least the limit past it
+    const SdfScene scene = RandomScene(300, 3);
+    int mismatches = 0, below = 0;
+    for (float limit : { 0.0f, 0.02f, 0.1f }) {
+        for (const Vector3& p : RandomPoints(20000, 4)) {
+            float exact = scene.DistanceBruteForce(p);
+            float limited = scene.Distance(p, limit);
+            if (exact < limit ? limited != exact : limited < limit)
+                mismatches++;
+            below += exact < limit;
+        }
+    }
+    CHECK(mismatches == 0);
+    CHECK(below > 1000);
+}
+
+TEST(SdfSceneGatheredDistance) {
+    // Over the gathered candidates, the same rules hold anywhere within the
+    // gather radius
+    const SdfScene scene = RandomScene(300, 5);
+    const float radius = 0.1f, limit = 0.05f;
+    std::mt19937 rng(6);
+    std::uniform_real_distribution<float> offset(-radius / 1.7320508f, radius / 1.7320508f);
+    std::vector<int> candidates;
+    int mismatches = 0, below = 0;
+    for (const Vector3& centre : RandomPoints(500, 7)) {
+        scene.Gather(centre, radius, limit, candidates);
+        for (int i = 0; i < 40; ++i) {
+            Vector3 p = centre + Vector3(offset(rng), offset(rng), offset(rng));
+            float exact = scene.DistanceBruteForce(p);
+            float gathered = scene.Distance(p, candidates);
+            if (exact < limit ? gathered != exact : gathered < limit)
+                mismatches++;
+            below += exact < limit;
+        }
+    }
+    CHECK(mismatches == 0);
+    CHECK(below > 1000);
+}
@@ -1,13 +1,84 @@
+// Smoke shading variant, set by the application when compiling:
+// 0 fixed tint, 1 transfer function, 2 pre-integrated transfer function
+#ifndef SHADING
+#define SHADING 0
+#endif
+
+// Solid variant: 0 tests the cube at every smoke sample, 1 sphere-traces it
+// first and marches the smoke only up to the hit, see CpuRenderSettings
+#ifndef SOLIDS
+#define SOLIDS 0
+#endif
+
 // 3D texture for smoke density
 Texture3D<float> SmokeDensityTexture : register(t0);
 SamplerState Sampler : register(s0);
 
+// Transfer function tables, see TransferFunction.hpp
+Texture1D<float4> TransferLut : register(t1);      // rgb, extinction
+Texture2D<float4> PreIntegratedLut : register(t2); // premultiplied rgb, alpha; x front, y back density
+
+cbuffer TransferConstants : register(b0)
+{
+    float maxDensity;    // Density at the last table entry
+    float transferStep;  // Step size of the transfer variants
+    float segmentLength; // Segment length PreIntegratedLut was baked for
+    float padding;
+};
+
+// Per-frame camera, see Camera.hpp
+cbuffer CameraConstants : register(b1)
+{
+    row_major float4x4 invViewProj; // Clip space to world space
+    float3 cameraPos;
+    float cameraPadding;
+};
+
+// Progressive refinement pass, see RefineSchedule in ProgressiveRenderer.hpp.
+// Non-progressive drawing binds stepScale 1, stepOffset 0.
+cbuffer RefineConstants : register(b2)
+{
+    float stepScale;     // Multiple of the base step marched this pass
+    float stepOffset;    // Start offset as a fraction of the step
+    float2 historyScale; // Part of HistoryTexture covered by the last pass
+};
+
+// Accumulated progressive image, drawn to the screen by Blit
+Texture2D<float4> HistoryTexture : register(t3);
+
+// Texel-centre coordinate of a density in a table of `size` entries
+float LutCoord(float density, float size)
+{
+    return (saturate(density / maxDensity) * (size - 1.0) + 0.5) / size;
+}
+
 float cubeSDF(float3 p, float3 cubeCenter, float3 cubeSize)
 {
     float3 d = abs(p - cubeCenter) - cubeSize;
     return length(max(d, 0.0)) + min(max(d.x, max(d.y, d.z)), 0.0);
 }
 
+// Unit gradient of cubeSDF from four lookups at the corners of a small tetrahedron
+float3 cubeNormal(float3 p, float3 cubeCenter, float3 cubeSize)
+{
+    const float h = 1e-4;
+    const float2 k = float2(1.0, -1.0);
+    return normalize(k.xyy * cubeSDF(p + k.xyy * h, cubeCenter, cubeSize) +
+                     k.yyx * cubeSDF(p + k.yyx * h, cubeCenter, cubeSize) +
+                     k.yxy * cubeSDF(p + k.yxy * h, cubeCenter, cubeSize) +
+                     k.xxx * cubeSDF(p + k.xxx * h, cubeCenter, cubeSize));
+}
+
+// Diffuse-lit cube surface
+float3 shadeCube(float3 p, float3 normal)
+{
+    float3 lightPosition = float3(1.0, -2.0, -.3);
+    float3 lightDir = normalize(lightPosition - p);
+    float3 cubeColor = float3(0.6, 0.6, 0.6);
+    float3 diffuse = cubeColor * max(dot(normal, lightDir), 0.0);
+    return float3(0.1, 0.1, 0.1) + diffuse; // phong shading
+}
+
 // Input and output structures
 struct VS_INPUT
 {
@@ -42,22 +113,9 @@ bool IntersectBoundingBox(float3 rayOrigin, float3 rayDir, float3 boxMin, float3
 
 float4 PS(PS_INPUT input) : SV_Target
 {
-    // Aspect ratio correction
-    float aspectRatio = 1000.0 / 800.0;
-    float2 correctedUV = float2((input.uv.x - 0.5) * aspectRatio, 0.5 - input.uv.y);
-
-    // Perspective projection
-    float fov = radians(90.0);
-    float3 cameraPos = float3(2, -1.5, -2);
-    float3 cameraTarget = float3(0.0, 0.0, 0.0);
-    float3 cameraUp = float3(0.0, 1.0, 0.0);
-
-    // Camera vectors
-    float3 forward = normalize(cameraTarget - cameraPos);
-    float3 right = normalize(cross(cameraUp, forward));
-    float3 up = cross(forward, right);
-
-    float3 rayDir = normalize(forward + correctedUV.x * right + correctedUV.y * up);
+    // Unproject the pixel onto the far plane
+    float4 farPoint = mul(invViewProj, float4(input.uv * 2.0 - 1.0, 1.0, 1.0));
+    float3 rayDir = normalize(farPoint.xyz / farPoint.w - cameraPos);
 
     // Bounding Box
     float3 boxMin = float3(-0.5, -1, -0.5);
@@ -72,51 +130,131 @@ float4 PS(PS_INPUT input) : SV_Target
         return float4(background, 1.0);
     }
     
-    float3 currentPos = cameraPos + tNear * rayDir;
     float sumDensity = 0.0;
-    float maxDensity = 1.0;
     float densityThreshold = 1e-50;
-    float stepSize = 0.001;
+#if SHADING == 0
+    float stepSize = 0.001 * stepScale;
+#else
+    float stepSize = transferStep * stepScale;
+    float3 radiance = float3(0.0, 0.0, 0.0);
+    float transmittance = 1.0;
+    float frontDensity = 0.0;
+    float2 lutSize;
+    PreIntegratedLut.GetDimensions(lutSize.x, lutSize.y);
+#endif
 
-    for (float t = tNear; t < tFar; t += stepSize)
+    float3 cubePosition = float3(0.0, -0.75, 0.0);
+    float3 cubeSize = float3(0.2, 0.2, 0.2);
+
+    float tEnd = tFar;
+#if SOLIDS == 1
+    // Sphere-trace the cube: every step advances by the distance to it, so
+    // the smoke below need only be marched up to the surface
+    bool hitCube = false;
+    float3 cubeHit = float3(0.0, 0.0, 0.0);
+    float tSolid = tNear;
+    for (int i = 0; i < 128 && tSolid < tFar; ++i)
+    {
+        float3 p = cameraPos + tSolid * rayDir;
+        float cubeDistance = cubeSDF(p, cubePosition, cubeSize);
+        if (cubeDistance <= 1e-4)
+        {
+            hitCube = true;
+            cubeHit = p;
+            tEnd = tSolid;
+            break;
+        }
+        tSolid += cubeDistance;
+    }
+#endif
+
+    float tStart = tNear + stepOffset * stepSize;
+    float3 currentPos = cameraPos + tStart * rayDir;
+
+    for (float t = tStart; t < tEnd; t += stepSize)
     {
         float3 texCoord = (currentPos - boxMin) / (boxMax - boxMin);
         float density = SmokeDensityTexture.SampleLevel(Sampler, texCoord, 0.0);
+#if SHADING == 0
         if (density > densityThreshold)
         {
             sumDensity += density * stepSize;
         }
-        
-        float3 cubePosition = float3(0.0, -0.75, 0.0);
-        float3 cubeSize = float3(0.2, 0.2, 0.2);
+#elif SHADING == 1
+        float4 rgbe = TransferLut.SampleLevel(Sampler, LutCoord(density, 256.0), 0.0);
+        float alpha = 1.0 - exp(-rgbe.a * stepSize);
+        radiance += rgbe.rgb * (transmittance * alpha);
+        transmittance *= 1.0 - alpha;
+#else
+        // Each sample closes the segment from the previous one; the table is
+        // rescaled from the length it was baked for
+        if (t > tStart)
+        {
+            float2 uv = float2(LutCoord(frontDensity, lutSize.x), LutCoord(density, lutSize.y));
+            float4 segment = PreIntegratedLut.SampleLevel(Sampler, uv, 0.0);
+            float alpha = 1.0 - pow(max(1.0 - segment.a, 0.0), stepSize / segmentLength);
+            float3 color = segment.a > 1e-6 ? segment.rgb * (alpha / segment.a) : segment.rgb * (stepSize / segmentLength);
+            radiance += color * transmittance;
+            transmittance *= 1.0 - alpha;
+        }
+        frontDensity = density;
+#endif
 
-        // Cube SDF check
-        if (cubeSDF(currentPos, cubePosition, cubeSize) <= stepSize)
+#if SOLIDS == 0
+        // Cube SDF check, against the base step so coarse passes keep the same outline
+        if (cubeSDF(currentPos, cubePosition, cubeSize) <= stepSize / stepScale)
         {
-            float3 lightPosition = float3(1.0, -2.0, -.3);
-            float3 lightColor = float3(0.5, 0.5, 0.5);            
-            float3 lightDir = normalize(lightPosition - currentPos);
-            
-            float3 cubeColor = float3(0.6, 0.6, 0.6);
-            
             float3 normal = normalize(currentPos - cubePosition); // ehhhhhh not exactly
-            
-            float3 diffuse = cubeColor * max(dot(normal, lightDir), 0.0);
-            
-            float4 boxColor = float4(float3(0.1, 0.1, 0.1) + diffuse, 1.0f); // phong shading
-            
+            float4 boxColor = float4(shadeCube(currentPos, normal), 1.0f);
+
+#if SHADING != 0
+            return float4(radiance + boxColor.rgb * transmittance, 1.0 - transmittance);
+#else
             float opacity = saturate(sumDensity);
             
             float3 smokeColor = float3(0.6, 0.4, 0.2) * opacity + background;
             
             return float4(smokeColor, opacity) + boxColor;
+#endif
+        }
+#endif
+
+#if SHADING != 0
+        if (transmittance < 0.002)
+        {
+            break;
         }
+#endif
 
         currentPos += rayDir * stepSize;
     }
-    
+
+#if SOLIDS == 1
+    if (hitCube)
+    {
+        float3 boxColor = shadeCube(cubeHit, cubeNormal(cubeHit, cubePosition, cubeSize));
+#if SHADING != 0
+        return float4(radiance + boxColor * transmittance, 1.0 - transmittance);
+#else
+        float opacity = saturate(sumDensity);
+        float3 smokeColor = float3(0.6, 0.4, 0.2) * opacity + background;
+        return float4(smokeColor, opacity) + float4(boxColor, 1.0);
+#endif
+    }
+#endif
+
+#if SHADING != 0
+    return float4(radiance + background * transmittance, 1.0 - transmittance);
+#else
     float opacity = saturate(sumDensity);
     float3 smokeColor = float3(0.6, 0.4, 0.2) * opacity + background;
     return float4(smokeColor, opacity);
+#endif
 }
 
+// Copies the progressive history to the screen, upscaling a preview
+float4 Blit(PS_INPUT input) : SV_Target
+{
+    float2 texCoord = float2(input.uv.x, 1.0 - input.uv.y) * historyScale;
+    return HistoryTexture.SampleLevel(Sampler, texCoord, 0.0);
+}
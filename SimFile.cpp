@@ -0,0 +1,253 @@
+#include "SimFile.hpp"
+
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+const char magic[4] = { 'S', 'M', 'K', 'S' };
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t width, height, depth;
+};
+
+struct ChunkHeader {
+    char tag[4];
+    uint32_t reserved;
+    uint64_t size;
+};
+
+struct IndexEntry {
+    char tag[4];
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// FEND chunk header plus its payload
+const uint64_t endBytes = sizeof(ChunkHeader) + sizeof(uint64_t);
+
+}
+
+bool SimFile::IsContainer(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char head[4] = {};
+    in.read(head, sizeof(head));
+    return in && std::memcmp(head, magic, sizeof(magic)) == 0;
+}
+
+bool SimChunk::Is(const char other[4]) const {
+    return std::memcmp(tag, other, 4) == 0;
+}
+
+bool SimFileWriter::Open(const std::string& path, int x, int y, int z) {
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+        return false;
+
+    width = x;
+    height = y;
+    depth = z;
+
+    FileHeader header = {};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = SimFile::Version;
+    header.width = x;
+    header.height = y;
+    header.depth = z;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    offset = sizeof(header);
+    chunks.clear();
+    return out.good();
+}
+
+bool SimFileWriter::Close() {
+    if (!out.is_open())
+        return false;
+
+    std::vector<IndexEntry> entries(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        std::memcpy(entries[i].tag, chunks[i].tag, 4);
+        entries[i].offset = chunks[i].offset;
+        entries[i].size = chunks[i].size;
+    }
+
+    uint64_t indexOffset = offset;
+    bool ok = WriteChunk(SimFile::IndexTag, entries.data(), entries.size() * sizeof(IndexEntry)) &&
+        WriteChunk(SimFile::EndTag, &indexOffset, sizeof(indexOffset));
+
+    out.close();
+    chunks.clear();
+    return ok && !out.fail();
+}
+
+bool SimFileWriter::WriteChunkHeader(const char tag[4], uint64_t size) {
+    ChunkHeader header = {};
+    std::memcpy(header.tag, tag, 4);
+    header.size = size;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // The index and footer are not listed in the index
+    if (std::memcmp(tag, SimFile::IndexTag, 4) != 0 && std::memcmp(tag, SimFile::EndTag, 4) != 0) {
+        SimChunk chunk = {};
+        std::memcpy(chunk.tag, tag, 4);
+        chunk.offset = offset + sizeof(header);
+        chunk.size = size;
+        chunks.push_back(chunk);
+    }
+    offset += sizeof(header) + size;
+    return out.good();
+}
+
+bool SimFileWriter::WriteChunk(const char tag[4], const void* data, size_t size) {
+    if (!WriteChunkHeader(tag, size))
+        return false;
+    out.write(static_cast<const char*>(data), size);
+    return out.good();
+}
+
+bool SimFileWriter::WriteFrame(int index, const VoxelGrid<float>& frame) {
+    if (frame.Width() != width || frame.Height() != height || frame.Depth() != depth)
+        return false;
+
+    int32_t frameIndex = index;
+    size_t bytes = frame.Size() * sizeof(float);
+    if (!WriteChunkHeader(SimFile::FrameTag, sizeof(frameIndex) + bytes))
+        return false;
+    out.write(reinterpret_cast<const char*>(&frameIndex), sizeof(frameIndex));
+    out.write(reinterpret_cast<const char*>(frame.Data()), bytes);
+    return out.good();
+}
+
+bool SimFileReader::Open(const std::string& path) {
+    Close();
+
+    in.open(path, std::ios::binary);
+    if (!in.is_open())
+        return false;
+
+    FileHeader header = {};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version > SimFile::Version) {
+        Close();
+        return false;
+    }
+    width = header.width;
+    height = header.height;
+    depth = header.depth;
+
+    const uint64_t fileSize = std::filesystem::file_size(path);
+    indexed = ReadIndex(fileSize);
+    if (!indexed)
+        Scan(fileSize);
+    in.clear();
+    return true;
+}
+
+bool SimFileReader::ReadIndex(uint64_t fileSize) {
+    if (fileSize < sizeof(FileHeader) + sizeof(ChunkHeader) + endBytes)
+        return false;
+
+    ChunkHeader end = {};
+    uint64_t indexOffset = 0;
+    in.seekg(static_cast<std::streamoff>(fileSize - endBytes));
+    in.read(reinterpret_cast<char*>(&end), sizeof(end));
+    in.read(reinterpret_cast<char*>(&indexOffset), sizeof(indexOffset));
+    if (!in || std::memcmp(end.tag, SimFile::EndTag, 4) != 0 || end.size != sizeof(indexOffset))
+        return false;
+    if (indexOffset > fileSize - endBytes - sizeof(ChunkHeader))
+        return false;
+
+    ChunkHeader header = {};
+    in.seekg(static_cast<std::streamoff>(indexOffset));
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.tag, SimFile::IndexTag, 4) != 0 || header.size % sizeof(IndexEntry) != 0
+        || header.size != fileSize - endBytes - indexOffset - sizeof(header))
+        return false;
+
+    std::vector<IndexEntry> entries(header.size / sizeof(IndexEntry));
+    in.read(reinterpret_cast<char*>(entries.data()), header.size);
+    if (!in)
+        return false;
+
+    for (const IndexEntry& e : entries) {
+        if (e.offset > indexOffset || e.size > indexOffset - e.offset) {
+            chunks.clear();
+            frameChunks.clear();
+            return false;
+        }
+
+        SimChunk chunk = {};
+        std::memcpy(chunk.tag, e.tag, 4);
+        chunk.offset = e.offset;
+        chunk.size = e.size;
+        if (chunk.Is(SimFile::FrameTag))
+            frameChunks.push_back(static_cast<int>(chunks.size()));
+        chunks.push_back(chunk);
+    }
+    return true;
+}
+
+void SimFileReader::Scan(uint64_t fileSize) {
+    // Walk the chunk headers, seeking over payloads
+    in.clear();
+    uint64_t offset = sizeof(FileHeader);
+    while (offset + sizeof(ChunkHeader) <= fileSize) {
+        ChunkHeader ch = {};
+        in.seekg(static_cast<std::streamoff>(offset));
+        in.read(reinterpret_cast<char*>(&ch), sizeof(ch));
+        if (!in)
+            break;
+
+        uint64_t payload = offset + sizeof(ch);
+        if (ch.size > fileSize - payload)
+            break; // Truncated chunk
+
+        SimChunk chunk = {};
+        std::memcpy(chunk.tag, ch.tag, 4);
+        chunk.offset = payload;
+        chunk.size = ch.size;
+        if (chunk.Is(SimFile::FrameTag))
+            frameChunks.push_back(static_cast<int>(chunks.size()));
+        if (!chunk.Is(SimFile::IndexTag) && !chunk.Is(SimFile::EndTag))
+            chunks.push_back(chunk);
+
+        offset = payload + ch.size;
+    }
+}
+
+void SimFileReader::Close() {
+    in.close();
+    in.clear();
+    chunks.clear();
+    frameChunks.clear();
+    indexed = false;
+    width = height = depth = 0;
+}
+
+bool SimFileReader::ReadChunk(const SimChunk& chunk, std::vector<char>& payload) {
+    payload.resize(chunk.size);
+    in.clear(); // A failed read would otherwise make the seek a no-op
+    in.seekg(static_cast<std::streamoff>(chunk.offset));
+    in.read(payload.data(), chunk.size);
+    return in.good();
+}
+
+bool SimFileReader::ReadFrame(int n, VoxelGrid<float>& frame) {
+    if (n < 0 || n >= FrameCount())
+        return false;
+    if (frame.Width() != width || frame.Height() != height || frame.Depth() != depth)
+        return false;
+
+    const SimChunk& chunk = chunks[frameChunks[n]];
+    size_t bytes = frame.Size() * sizeof(float);
+    if (chunk.size != sizeof(int32_t) + bytes)
+        return false;
+
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(chunk.offset + sizeof(int32_t)));
+    in.read(reinterpret_cast<char*>(frame.Data()), bytes);
+    return in.good();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "VoxelGrid.hpp"
+
+// Binary simulation container: a header followed by tagged chunks.
+//   header: "SMKS", uint32 version, int32 width, height, depth
+//   chunk:  char tag[4], uint32 reserved, uint64 payload size, payload
+// FRAM chunks hold one density frame (int32 index, then width*height*depth
+// floats); CKPT chunks hold a solver checkpoint. Readers skip unknown tags
+// and ignore a truncated trailing chunk, so a file cut short still opens.
+//
+// A cleanly closed file ends with an FIDX chunk listing every chunk (tag,
+// reserved, uint64 offset, uint64 size per entry) and an FEND chunk holding
+// the uint64 file offset of the FIDX chunk header. Readers use it to open
+// without walking the file; without it they fall back to scanning.
+namespace SimFile {
+    const char FrameTag[4] = { 'F', 'R', 'A', 'M' };
+    const char CheckpointTag[4] = { 'C', 'K', 'P', 'T' };
+    const char IndexTag[4] = { 'F', 'I', 'D', 'X' };
+    const char EndTag[4] = { 'F', 'E', 'N', 'D' };
+    const uint32_t Version = 1;
+
+    // True if the path names a container rather than an ASCII info.sim
+    bool IsContainer(const std::string& path);
+}
+
+struct SimChunk {
+    char tag[4];
+    uint64_t offset; // Payload offset in the file
+    uint64_t size;   // Payload size
+
+    bool Is(const char other[4]) const;
+};
+
+class SimFileWriter {
+public:
+    bool Open(const std::string& path, int x, int y, int z);
+    // Writes the chunk index and closes. False if anything failed to write.
+    bool Close();
+    bool IsOpen() const { return out.is_open(); }
+
+    bool WriteChunk(const char tag[4], const void* data, size_t size);
+    bool WriteFrame(int index, const VoxelGrid<float>& frame);
+
+private:
+    bool WriteChunkHeader(const char tag[4], uint64_t size);
+
+    std::ofstream out;
+    int width = 0, height = 0, depth = 0;
+    uint64_t offset = 0; // Bytes written so far
+    std::vector<SimChunk> chunks;
+};
+
+class SimFileReader {
+public:
+    bool Open(const std::string& path);
+    void Close();
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    int Depth() const { return depth; }
+
+    const std::vector<SimChunk>& Chunks() const { return chunks; }
+    int FrameCount() const { return static_cast<int>(frameChunks.size()); }
+
+    // True if Open() found the trailing index rather than scanning.
+    bool Indexed() const { return indexed; }
+
+    bool ReadChunk(const SimChunk& chunk, std::vector<char>& payload);
+    // Reads the n-th FRAM chunk into `frame`, which must match the header size.
+    // One seek and one read, wherever the frame lies in the file.
+    bool ReadFrame(int n, VoxelGrid<float>& frame);
+
+private:
+    bool ReadIndex(uint64_t fileSize);
+    void Scan(uint64_t fileSize);
+
+    std::ifstream in;
+    bool indexed = false;
+    int width = 0, height = 0, depth = 0;
+    std::vector<SimChunk> chunks;
+    std::vector<int> frameChunks;
+};
@@ -0,0 +1,62 @@
+#include "FakeVolume.hpp"
+#include "SimFile.hpp"
+#include "Tests.hpp"
+
+#include <filesystem>
+
+namespace {
+
+// Writes `frames` to a container in the temp directory and returns its path
+std::string WriteContainer(const std::string& name, const std::vector<VoxelGrid<float>>& frames) {
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+    SimFileWriter writer;
+    if (!writer.Open(path, frames[0].Width(), frames[0].Height(), frames[0].Depth()))
+        return "";
+    for (size_t i = 0; i < frames.size(); ++i)
+        writer.WriteFrame(static_cast<int>(i), frames[i]);
+    return writer.Close() ? path : "";
+}
+
+}
+
+TEST(SimFileReadsFrames) {
+    std::vector<VoxelGrid<float>> frames = { TestVolume(8, 6, 4, 1), TestVolume(8, 6, 4, 2), TestVolume(8, 6, 4, 3) };
+    const std::string path = WriteContainer("simfile_reads.smk", frames);
+    CHECK(!path.empty());
+
+    SimFileReader reader;
+    CHECK(reader.Open(path));
+    CHECK(reader.Indexed());
+    CHECK(reader.FrameCount() == 3);
+    VoxelGrid<float> frame(8, 6, 4);
+    for (int n = 2; n >= 0; --n) {
+        CHECK(reader.ReadFrame(n, frame));
+        CHECK(SameVoxels(frame, frames[n]));
+    }
+    reader.Close();
+    std::filesystem::remove(path);
+}
+
+TEST(SimFileReadsAfterFailedRead) {
+    // A read past the end of the file leaves the stream failed; the next
+    // valid read must still succeed
+    std::vector<VoxelGrid<float>> frames = { TestVolume(8, 6, 4, 1), TestVolume(8, 6, 4, 2) };
+    const std::string path = WriteContainer("simfile_failed_read.smk", frames);
+    CHECK(!path.empty());
+
+    SimFileReader reader;
+    CHECK(reader.Open(path));
+    SimChunk missing = reader.Chunks()[0];
+    missing.offset = std::filesystem::file_size(path) - 4;
+    std::vector<char> payload;
+    CHECK(!reader.ReadChunk(missing, payload));
+
+    VoxelGrid<float> frame(8, 6, 4);
+    CHECK(reader.ReadFrame(1, frame));
+    CHECK(SameVoxels(frame, frames[1]));
+    CHECK(!reader.ReadChunk(missing, payload));
+    CHECK(reader.ReadChunk(reader.Chunks()[0], payload));
+    CHECK(payload.size() == reader.Chunks()[0].size);
+    reader.Close();
+    std::filesystem::remove(path);
+}
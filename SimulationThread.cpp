@@ -0,0 +1,279 @@
+#include "SimulationThread.hpp"
+#include "FrameBlend.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Largest solver step taken after a stall (e.g. the window being dragged)
+const double maxStepSeconds = 0.1;
+
+// Live tracers
+const size_t tracerCapacity = 1 << 20;
+const float tracerRate = 20000.0f;   // Per source, per solver second
+const float tracerDensity = 0.05f;   // Splatted per particle
+
+}
+
+SimulationThread::~SimulationThread() {
+    Stop();
+}
+
+void SimulationThread::StartPlayback(const std::vector<VoxelGrid<float>>* frames, double rate) {
+    StartPlayback(std::make_unique<MemoryFrameSource>(frames), rate);
+}
+
+void SimulationThread::StartPlayback(std::unique_ptr<IFrameSource> source, double rate) {
+    Stop();
+
+    playback = std::move(source);
+    clock.Reset(playback->FrameCount());
+    tickSeconds = 1.0 / rate;
+
+    // Blends, and frames from a streaming source, are built in pooled buffers
+    if (playback->FrameCount() > 0) {
+        buffers.assign(PoolBuffers, VoxelGrid<float>(playback->Width(), playback->Height(), playback->Depth()));
+        for (int i = 0; i < PoolBuffers; ++i)
+            freeBuffers.TryPush(i);
+    }
+    playing = false;
+    seekTarget = 0; // Publish the first frame straight away
+
+    quit = false;
+    worker = std::thread(&SimulationThread::Run, this);
+}
+
+void SimulationThread::StartLive(std::unique_ptr<SmokeSolver> liveSolver, double rate, float timeScale) {
+    Stop();
+
+    solver = std::move(liveSolver);
+    solverTimeScale = timeScale;
+    tickSeconds = 1.0 / rate;
+
+    const VoxelGrid<float>& density = solver->Fields().density;
+    buffers.assign(PoolBuffers, VoxelGrid<float>(density.Width(), density.Height(), density.Depth()));
+    for (int i = 0; i < PoolBuffers; ++i)
+        freeBuffers.TryPush(i);
+    playing = true;
+
+    particles.reset();
+    tracerCount = 0;
+
+    lastCheckpointStep = solver->LastStats().steps;
+    checkpointRequested = false;
+    if (!checkpointPath.empty())
+        checkpoints.Start(checkpointPath, density.Width(), density.Height(), density.Depth());
+
+    quit = false;
+    worker = std::thread(&SimulationThread::Run, this);
+}
+
+void SimulationThread::Stop() {
+    if (worker.joinable()) {
+        quit = true;
+        worker.join();
+    }
+    checkpoints.Stop();
+
+    // Frames taken before Stop() point into these and are invalid afterwards
+    frames.Reset();
+    freeBuffers.Reset();
+    spareBuffer = -1;
+    buffers.clear();
+    solver.reset();
+    particles.reset();
+    tracerCount = 0;
+    playback.reset();
+    playing = false;
+    seekTarget = -1;
+}
+
+void SimulationThread::SetCheckpoints(const std::string& path, int interval) {
+    checkpointPath = path;
+    checkpointInterval = interval;
+}
+
+bool SimulationThread::TakeLatest(SimFrame& frame) {
+    SimFrame next;
+    bool any = false;
+    bool seek = false;
+    while (frames.TryPop(next)) {
+        if (any)
+            Release(frame);
+        seek = seek || next.seek;
+        frame = next;
+        any = true;
+    }
+    if (any)
+        frame.seek = seek;
+    return any;
+}
+
+void SimulationThread::Release(const SimFrame& frame) {
+    if (frame.buffer >= 0)
+        freeBuffers.TryPush(frame.buffer);
+}
+
+void SimulationThread::Run() {
+    Profiler::SetThreadName("Simulation");
+
+    const auto tick = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(tickSeconds));
+    auto last = Clock::now();
+    auto next = last;
+
+    while (!quit) {
+        auto now = Clock::now();
+
+        if (solver) {
+            double dt = std::min(std::chrono::duration<double>(now - last).count(), maxStepSeconds);
+            last = now;
+            if (playing) {
+                {
+                    PROFILE_SCOPE("Solver advance");
+                    solver->Advance(static_cast<float>(dt) * solverTimeScale);
+                }
+                StepTracers(static_cast<float>(dt) * solverTimeScale);
+                PublishLive();
+
+                int step = solver->LastStats().steps;
+                bool due = checkpointInterval > 0 && step - lastCheckpointStep >= checkpointInterval;
+                if (checkpointRequested.exchange(false) || due) {
+                    checkpoints.Submit(*solver, step);
+                    lastCheckpointStep = step;
+                }
+            }
+        }
+        else {
+            int seek = seekTarget.exchange(-1);
+            if (seek >= 0 && playback->FrameCount() > 0) {
+                clock.Seek(seek);
+                PublishPlayback(clock.Position(), true);
+            }
+            else if (playing) {
+                if (!clock.Advance(speed)) {
+                    playing = false;
+                    clock.Seek(0);
+                }
+                PublishPlayback(clock.Position(), false);
+            }
+        }
+
+        // Fixed rate; if a tick overran, start counting again from now
+        next += tick;
+        if (next < now)
+            next = now + tick;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void SimulationThread::PublishPlayback(double position, bool seek) {
+    PROFILE_SCOPE("Publish playback");
+    const int count = playback->FrameCount();
+    int frame = static_cast<int>(position);
+    int step = static_cast<int>(std::lround((position - frame) * BlendSteps));
+    if (step == BlendSteps) {
+        frame++;
+        step = 0;
+    }
+    if (frame >= count)
+        return;
+
+    SimFrame f;
+    f.index = frame;
+    f.position = position;
+    f.key = frame;
+    f.seek = seek;
+
+    int buffer = -1;
+    bool blend = interpolate && step > 0 && frame + 1 < count;
+    if (blend || !playback->Resident()) {
+        if (!TakeBuffer(buffer)) {
+            if (!playback->Resident())
+                return; // Renderer still holds every buffer
+            blend = false;
+        }
+    }
+
+    if (buffer >= 0) {
+        const VoxelGrid<float>* a = playback->Frame(frame);
+        const VoxelGrid<float>* b = blend ? playback->Frame(frame + 1) : nullptr;
+        if (!a || (blend && !b)) {
+            spareBuffer = buffer;
+            return;
+        }
+
+        if (blend) {
+            BlendFrames(*a, *b, static_cast<float>(step) / BlendSteps, buffers[buffer]);
+            f.key = -(1 + static_cast<int64_t>(frame) * BlendSteps + step);
+        }
+        else {
+            buffers[buffer] = *a;
+        }
+        f.grid = &buffers[buffer];
+        f.buffer = buffer;
+    }
+    else {
+        // Resident exact frame, interpolation off, or every blend buffer in use
+        f.grid = playback->Frame(frame);
+    }
+
+    // A full queue means the renderer is behind; drop the frame but keep its
+    // buffer, since only the renderer may push to freeBuffers
+    if (!frames.TryPush(f) && buffer >= 0)
+        spareBuffer = buffer;
+}
+
+bool SimulationThread::TakeBuffer(int& buffer) {
+    if (spareBuffer >= 0) {
+        buffer = spareBuffer;
+        spareBuffer = -1;
+        return true;
+    }
+    return freeBuffers.TryPop(buffer);
+}
+
+void SimulationThread::PublishLive() {
+    PROFILE_SCOPE("Publish live");
+    int buffer;
+    if (!freeBuffers.TryPop(buffer))
+        return; // Renderer still holds every buffer
+
+    if (particles)
+        splatter.Splat(particles->Positions(), particles->Count(), buffers[buffer]);
+    else
+        buffers[buffer] = solver->Fields().density;
+
+    SimFrame f;
+    f.grid = &buffers[buffer];
+    f.index = solver->LastStats().steps;
+    f.position = f.index;
+    f.key = f.index;
+    f.buffer = buffer;
+    f.stats = solver->LastStats();
+    frames.TryPush(f); // QueueSize > PoolBuffers, so a pooled frame always fits
+}
+
+void SimulationThread::StepTracers(float dt) {
+    if (!tracers) {
+        particles.reset();
+        tracerCount = 0;
+        return;
+    }
+
+    if (!particles) {
+        particles = std::make_unique<ParticleSystem>(tracerCapacity);
+        for (const SmokeSource& source : solver->sources) {
+            Vector3 r(source.radius, source.radius, source.radius);
+            particles->emitters.push_back({ source.center - r, source.center + r, tracerRate });
+        }
+        splatter.density = tracerDensity;
+    }
+
+    particles->Step(VelocityField::Collocated(solver->Fields(), solver->params.cellSize), dt);
+    tracerCount = particles->Count();
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Checkpoint.hpp"
+#include "FrameSource.hpp"
+#include "ParticleSplat.hpp"
+#include "ParticleSystem.hpp"
+#include "PlaybackClock.hpp"
+#include "SmokeSolver.hpp"
+#include "SpscQueue.hpp"
+#include "VoxelGrid.hpp"
+
+// A completed density frame handed from the simulation thread to the renderer.
+struct SimFrame {
+    const VoxelGrid<float>* grid = nullptr;
+    int index = 0;       // Playback frame or solver step
+    double position = 0; // Playback position, fractional between frames
+    int64_t key = 0;     // Identifies the contents: `index`, or negative for a blend
+    bool seek = false;   // Published in response to Seek()
+    int buffer = -1;     // Pooled buffer to hand back with Release(), -1 if not owned
+    SolverStats stats;   // Live solver only
+};
+
+// Runs playback or the live solver on its own thread at a fixed tick rate and
+// publishes frames through a lock-free queue. The producer never waits on the
+// consumer: if the queue or the buffer pool is full the frame is dropped.
+class SimulationThread {
+public:
+    static constexpr int QueueSize = 8;
+    static constexpr int PoolBuffers = 4; // Live frames and playback blends
+    static constexpr int BlendSteps = 1024; // Blend weights are quantized to this
+
+    ~SimulationThread();
+
+    // Plays back `frames`, which must stay alive and unchanged until Stop().
+    void StartPlayback(const std::vector<VoxelGrid<float>>* frames, double rate);
+    void StartPlayback(std::unique_ptr<IFrameSource> source, double rate);
+    void StartLive(std::unique_ptr<SmokeSolver> solver, double rate, float timeScale);
+    void Stop();
+
+    bool Running() const { return worker.joinable(); }
+    bool Live() const { return solver != nullptr; }
+
+    // Live solver checkpoints go to `path` every `interval` steps (0 = only on
+    // request). Takes effect on the next StartLive().
+    void SetCheckpoints(const std::string& path, int interval);
+    void RequestCheckpoint() { checkpointRequested = true; }
+    int LastCheckpointStep() const { return checkpoints.LastWrittenStep(); }
+
+    void SetPlaying(bool play) { playing = play; }
+    bool Playing() const { return playing; }
+    void Seek(int frame) { seekTarget = frame; }
+
+    // Playback speed in stored frames per tick; below 1 is slow motion.
+    void SetSpeed(float s) { speed = s; }
+    float Speed() const { return speed; }
+    // Show positions between stored frames as a linear blend of the two
+    // rather than holding the earlier one.
+    void SetInterpolate(bool on) { interpolate = on; }
+    bool Interpolating() const { return interpolate; }
+
+    // Live solver only: publish tracer particles carried by the solver's
+    // velocity, splatted into a density grid, instead of the smoke itself.
+    // Tracers restart from the sources each time this is switched on.
+    void SetTracers(bool on) { tracers = on; }
+    bool Tracers() const { return tracers; }
+    size_t TracerCount() const { return tracerCount; }
+
+    // Consumer side. Returns the newest published frame, releasing any older
+    // ones it skips (their seek flag carries over); false if nothing new
+    // arrived since the last call.
+    bool TakeLatest(SimFrame& frame);
+    // Returns a frame's buffer to the pool once its data has been consumed.
+    void Release(const SimFrame& frame);
+
+private:
+    void Run();
+    void PublishPlayback(double position, bool seek);
+    void PublishLive();
+    void StepTracers(float dt);
+    bool TakeBuffer(int& buffer);
+
+    std::thread worker;
+    std::atomic<bool> quit = false;
+    std::atomic<bool> playing = false;
+    std::atomic<int> seekTarget = -1;
+    std::atomic<float> speed = 1.0f;
+    std::atomic<bool> interpolate = true;
+    double tickSeconds = 1.0 / 60.0;
+
+    std::unique_ptr<IFrameSource> playback;
+    PlaybackClock clock;
+
+    std::unique_ptr<SmokeSolver> solver;
+    float solverTimeScale = 1.0f;
+    std::atomic<bool> tracers = false;
+    std::atomic<size_t> tracerCount = 0;
+    std::unique_ptr<ParticleSystem> particles;
+    ParticleSplatter splatter;
+    std::vector<VoxelGrid<float>> buffers;
+    int spareBuffer = -1; // Owned by the simulation thread after a dropped blend
+
+    CheckpointWriter checkpoints;
+    std::string checkpointPath;
+    int checkpointInterval = 0;
+    int lastCheckpointStep = 0;
+    std::atomic<bool> checkpointRequested = false;
+
+    SpscQueue<SimFrame, QueueSize> frames;     // Simulation -> renderer
+    SpscQueue<int, PoolBuffers> freeBuffers;   // Renderer -> simulation
+};
@@ -0,0 +1,265 @@
+#include "SmokeForces.hpp"
+#include "BrickMask.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+SmokeFields::SmokeFields(int x, int y, int z)
+    : u(x, y, z), v(x, y, z), w(x, y, z), density(x, y, z), temperature(x, y, z) {}
+
+namespace {
+
+// Neighbour indices for a central difference, falling back to one-sided
+// differences on the domain border.
+struct Stencil {
+    int lo, hi;
+    float scale;
+};
+
+inline Stencil MakeStencil(int c, int n, float invH) {
+    int lo = c > 0 ? c - 1 : c;
+    int hi = c < n - 1 ? c + 1 : c;
+    return { lo, hi, hi > lo ? invH / static_cast<float>(hi - lo) : 0.0f };
+}
+
+struct GridView {
+    const float* u;
+    const float* v;
+    const float* w;
+    int x, y, z;
+    size_t Index(int i, int j, int k) const { return i + static_cast<size_t>(x) * (j + static_cast<size_t>(y) * k); }
+};
+
+// Writes (wx, wy, wz, |w|) for voxel (i, j, k).
+inline void CurlAt(const GridView& g, int i, int j, int k, float invH, float* out) {
+    Stencil sx = MakeStencil(i, g.x, invH);
+    Stencil sy = MakeStencil(j, g.y, invH);
+    Stencil sz = MakeStencil(k, g.z, invH);
+
+    size_t xl = g.Index(sx.lo, j, k), xh = g.Index(sx.hi, j, k);
+    size_t yl = g.Index(i, sy.lo, k), yh = g.Index(i, sy.hi, k);
+    size_t zl = g.Index(i, j, sz.lo), zh = g.Index(i, j, sz.hi);
+
+    float dwdy = (g.w[yh] - g.w[yl]) * sy.scale;
+    float dvdz = (g.v[zh] - g.v[zl]) * sz.scale;
+    float dudz = (g.u[zh] - g.u[zl]) * sz.scale;
+    float dwdx = (g.w[xh] - g.w[xl]) * sx.scale;
+    float dvdx = (g.v[xh] - g.v[xl]) * sx.scale;
+    float dudy = (g.u[yh] - g.u[yl]) * sy.scale;
+
+    out[0] = dwdy - dvdz;
+    out[1] = dudz - dwdx;
+    out[2] = dvdx - dudy;
+    out[3] = std::sqrt(out[0] * out[0] + out[1] * out[1] + out[2] * out[2]);
+}
+
+// Confinement force eps * h * (N x w) where N = grad|w| / |grad|w||.
+// Curl records are (wx, wy, wz, |w|); the six neighbours follow the same
+// stencil as CurlAt so border voxels use one-sided gradients.
+inline void ConfinementAt(const float* c,
+    const float* xl, const float* xh, const float* yl, const float* yh, const float* zl, const float* zh,
+    const Stencil& sx, const Stencil& sy, const Stencil& sz, float strength, float* out) {
+    float gx = (xh[3] - xl[3]) * sx.scale;
+    float gy = (yh[3] - yl[3]) * sy.scale;
+    float gz = (zh[3] - zl[3]) * sz.scale;
+    float invLen = 1.0f / (std::sqrt(gx * gx + gy * gy + gz * gz) + 1e-6f);
+    gx *= invLen;
+    gy *= invLen;
+    gz *= invLen;
+
+    out[0] = strength * (gy * c[2] - gz * c[1]);
+    out[1] = strength * (gz * c[0] - gx * c[2]);
+    out[2] = strength * (gx * c[1] - gy * c[0]);
+}
+
+// CurlAt over voxels i0..i1-1 of row (j, k), writing records to out + 4 * i.
+// Interior voxels share the y and z stencils and take the central x
+// difference directly; the arithmetic matches CurlAt exactly.
+inline void CurlRow(const GridView& g, int i0, int i1, int j, int k, float invH, float* out) {
+    const Stencil sy = MakeStencil(j, g.y, invH);
+    const Stencil sz = MakeStencil(k, g.z, invH);
+    const int first = std::max(i0, 1), last = std::min(i1, g.x - 1);
+    for (int i = i0; i < std::min(first, i1); ++i)
+        CurlAt(g, i, j, k, invH, out + 4 * i);
+    if (first < last) {
+        const Stencil sx = MakeStencil(first, g.x, invH);
+        const size_t c = g.Index(0, j, k);
+        const size_t yl = g.Index(0, sy.lo, k), yh = g.Index(0, sy.hi, k);
+        const size_t zl = g.Index(0, j, sz.lo), zh = g.Index(0, j, sz.hi);
+        for (int i = first; i < last; ++i) {
+            float dwdy = (g.w[yh + i] - g.w[yl + i]) * sy.scale;
+            float dvdz = (g.v[zh + i] - g.v[zl + i]) * sz.scale;
+            float dudz = (g.u[zh + i] - g.u[zl + i]) * sz.scale;
+            float dwdx = (g.w[c + i + 1] - g.w[c + i - 1]) * sx.scale;
+            float dvdx = (g.v[c + i + 1] - g.v[c + i - 1]) * sx.scale;
+            float dudy = (g.u[yh + i] - g.u[yl + i]) * sy.scale;
+
+            float* o = out + 4 * i;
+            o[0] = dwdy - dvdz;
+            o[1] = dudz - dwdx;
+            o[2] = dvdx - dudy;
+            o[3] = std::sqrt(o[0] * o[0] + o[1] * o[1] + o[2] * o[2]);
+        }
+    }
+    for (int i = std::max(last, i0); i < i1; ++i)
+        CurlAt(g, i, j, k, invH, out + 4 * i);
+}
+
+// ConfinementAt for voxel i of a row, given the curl rows of the row itself
+// (mid), its y neighbours (ylo, yhi) and z neighbours (zlo, zhi).
+inline void ConfinementInRow(const float* mid, const float* ylo, const float* yhi, const float* zlo, const float* zhi,
+    int i, int x, const Stencil& sy, const Stencil& sz, float invH, float strength, float* out) {
+    const Stencil sx = i > 0 && i < x - 1 ? Stencil{ i - 1, i + 1, invH / 2.0f } : MakeStencil(i, x, invH);
+    ConfinementAt(mid + 4 * i, mid + 4 * sx.lo, mid + 4 * sx.hi, ylo + 4 * i, yhi + 4 * i, zlo + 4 * i, zhi + 4 * i,
+        sx, sy, sz, strength, out);
+}
+
+inline float BuoyancyAt(const ForceParams& p, float density, float temperature) {
+    return -p.densityWeight * density + p.temperatureWeight * (temperature - p.ambientTemperature);
+}
+
+using Clock = std::chrono::steady_clock;
+
+double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}
+
+void SmokeForces::Apply(SmokeFields& fields, float dt, const BrickMask* active) {
+    auto start = Clock::now();
+
+    const int X = fields.Width(), Y = fields.Height(), Z = fields.Depth();
+    const size_t slice = static_cast<size_t>(X) * Y;
+    const float invH = 1.0f / params.cellSize;
+    const float strength = params.vorticity * params.cellSize;
+
+    GridView g = { fields.u.Data(), fields.v.Data(), fields.w.Data(), X, Y, Z };
+    float* u = fields.u.Data();
+    float* v = fields.v.Data();
+    float* w = fields.w.Data();
+    const float* density = fields.density.Data();
+    const float* temperature = fields.temperature.Data();
+
+    curlWindow.resize(3 * slice * 4);
+    auto windowSlice = [&](int k) { return curlWindow.data() + (k % 3) * slice * 4; };
+
+    // Calls fn(i0, i1, on) for each brick-wide run of row (j, k).
+    auto forEachRun = [&](int j, int k, auto&& fn) {
+        if (!active) {
+            fn(0, X, true);
+            return;
+        }
+        for (int i0 = 0; i0 < X; i0 += BrickMask::Size)
+            fn(i0, std::min(i0 + BrickMask::Size, X), active->TestVoxel(i0, j, k));
+    };
+
+    auto computeCurlSlice = [&](int k) {
+        float* dst = windowSlice(k);
+        for (int j = 0; j < Y; ++j)
+            forEachRun(j, k, [&](int i0, int i1, bool on) {
+                float* row = dst + 4 * (static_cast<size_t>(X) * j);
+                if (!on) {
+                    std::fill(row + 4 * i0, row + 4 * i1, 0.0f);
+                    return;
+                }
+                CurlRow(g, i0, i1, j, k, invH, row);
+            });
+    };
+
+    computeCurlSlice(0);
+    for (int k = 0; k < Z; ++k) {
+        // Slice k+1 only needs velocity from k..k+2, none of which has been
+        // written yet, so the window stays consistent with the unfused passes.
+        if (k + 1 < Z)
+            computeCurlSlice(k + 1);
+
+        Stencil sz = MakeStencil(k, Z, invH);
+        const float* zlo = windowSlice(sz.lo);
+        const float* zmid = windowSlice(k);
+        const float* zhi = windowSlice(sz.hi);
+
+        for (int j = 0; j < Y; ++j) {
+            Stencil sy = MakeStencil(j, Y, invH);
+            const size_t row = 4 * (static_cast<size_t>(X) * j);
+            const size_t rowLo = 4 * (static_cast<size_t>(X) * sy.lo), rowHi = 4 * (static_cast<size_t>(X) * sy.hi);
+            forEachRun(j, k, [&](int i0, int i1, bool on) {
+                if (!on)
+                    return;
+                const size_t base = static_cast<size_t>(X) * j + slice * k;
+                for (int i = i0; i < i1; ++i) {
+                    float f[3];
+                    ConfinementInRow(zmid + row, zmid + rowLo, zmid + rowHi, zlo + row, zhi + row, i, X, sy, sz, invH,
+                        strength, f);
+                    size_t idx = base + i;
+                    f[1] += BuoyancyAt(params, density[idx], temperature[idx]);
+                    u[idx] += dt * f[0];
+                    v[idx] += dt * f[1];
+                    w[idx] += dt * f[2];
+                }
+            });
+        }
+    }
+
+    size_t voxels = active ? active->ActiveVoxels() : slice * Z;
+    stats.seconds = SecondsSince(start);
+    stats.bytes = static_cast<double>(voxels) * sizeof(float) * (3 + 2 + 3); // uvw + rho,T in, uvw out
+    stats.sweeps = 1;
+}
+
+void SmokeForces::ApplyUnfused(SmokeFields& fields, float dt) {
+    auto start = Clock::now();
+
+    const int X = fields.Width(), Y = fields.Height(), Z = fields.Depth();
+    const size_t slice = static_cast<size_t>(X) * Y;
+    const size_t voxels = slice * Z;
+    const float invH = 1.0f / params.cellSize;
+    const float strength = params.vorticity * params.cellSize;
+
+    GridView g = { fields.u.Data(), fields.v.Data(), fields.w.Data(), X, Y, Z };
+    curl.resize(voxels * 4);
+    force.resize(voxels * 3);
+
+    // Pass 1: curl
+    for (int k = 0; k < Z; ++k)
+        for (int j = 0; j < Y; ++j)
+            CurlRow(g, 0, X, j, k, invH, curl.data() + 4 * g.Index(0, j, k));
+
+    // Pass 2: gradient of |curl| and confinement force
+    for (int k = 0; k < Z; ++k) {
+        Stencil sz = MakeStencil(k, Z, invH);
+        for (int j = 0; j < Y; ++j) {
+            Stencil sy = MakeStencil(j, Y, invH);
+            const float* c = curl.data();
+            const float* mid = c + 4 * g.Index(0, j, k);
+            const float* ylo = c + 4 * g.Index(0, sy.lo, k);
+            const float* yhi = c + 4 * g.Index(0, sy.hi, k);
+            const float* zlo = c + 4 * g.Index(0, j, sz.lo);
+            const float* zhi = c + 4 * g.Index(0, j, sz.hi);
+            for (int i = 0; i < X; ++i)
+                ConfinementInRow(mid, ylo, yhi, zlo, zhi, i, X, sy, sz, invH, strength, force.data() + 3 * g.Index(i, j, k));
+        }
+    }
+
+    // Pass 3: buoyancy and integration
+    float* u = fields.u.Data();
+    float* v = fields.v.Data();
+    float* w = fields.w.Data();
+    const float* density = fields.density.Data();
+    const float* temperature = fields.temperature.Data();
+    for (size_t idx = 0; idx < voxels; ++idx) {
+        const float* f = force.data() + 3 * idx;
+        float fy = f[1] + BuoyancyAt(params, density[idx], temperature[idx]);
+        u[idx] += dt * f[0];
+        v[idx] += dt * fy;
+        w[idx] += dt * f[2];
+    }
+
+    stats.seconds = SecondsSince(start);
+    stats.bytes = static_cast<double>(voxels) * sizeof(float) *
+        ((3 + 4) +            // curl: uvw in, curl out
+         (4 + 3) +            // confinement: curl in, force out
+         (3 + 2 + 3 + 3));    // integrate: force, rho,T, uvw in, uvw out
+    stats.sweeps = 3;
+}
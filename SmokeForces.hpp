@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include "VoxelGrid.hpp"
+
+class BrickMask;
+
+// Collocated velocity plus the scalar fields that drive buoyancy.
+struct SmokeFields {
+    VoxelGrid<float> u, v, w;
+    VoxelGrid<float> density;
+    VoxelGrid<float> temperature;
+
+    SmokeFields(int x = 16, int y = 16, int z = 16);
+
+    int Width() const { return density.Width(); }
+    int Height() const { return density.Height(); }
+    int Depth() const { return density.Depth(); }
+};
+
+struct ForceParams {
+    float vorticity = 0.35f;         // Confinement strength (epsilon)
+    float densityWeight = 0.08f;     // Buoyancy alpha, smoke sinks with density
+    float temperatureWeight = 0.97f; // Buoyancy beta, hot smoke rises
+    float ambientTemperature = 0.0f;
+    float cellSize = 1.0f;
+};
+
+// Timing of the last force pass. Bytes are the nominal DRAM traffic of the
+// pass (every field read or written once per sweep), not a hardware counter.
+struct ForceStats {
+    double seconds = 0.0;
+    double bytes = 0.0;
+    int sweeps = 0;
+
+    double BandwidthGBs() const { return seconds > 0.0 ? bytes / seconds * 1e-9 : 0.0; }
+};
+
+// Vorticity confinement and buoyancy.
+// Apply() computes curl, the gradient of |curl| and the resulting force in a
+// single sweep, keeping only a three-slice window of curl values live.
+// ApplyUnfused() is the textbook three-pass version kept as a reference and
+// for bandwidth comparisons; both produce identical results.
+// Passing an active brick mask restricts Apply() to the flagged bricks; curl
+// outside them is treated as zero.
+class SmokeForces {
+public:
+    ForceParams params;
+
+    void Apply(SmokeFields& fields, float dt, const BrickMask* active = nullptr);
+    void ApplyUnfused(SmokeFields& fields, float dt);
+
+    const ForceStats& LastStats() const { return stats; }
+
+private:
+    std::vector<float> curlWindow; // 3 slices of (wx, wy, wz, |w|)
+    std::vector<float> curl;       // Unfused: full grid of (wx, wy, wz, |w|)
+    std::vector<float> force;      // Unfused: full grid of (fx, fy, fz)
+    ForceStats stats;
+};
@@ -0,0 +1,500 @@
+#include "SmokeSolver.hpp"
+#include "ParallelFor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double SecondsBetween(Clock::time_point a, Clock::time_point b) {
+    return std::chrono::duration<double>(b - a).count();
+}
+
+void ZeroRange(VoxelGrid<float>& g, const BrickRange& r) {
+    for (int z = r.z0; z < r.z1; ++z)
+        for (int y = r.y0; y < r.y1; ++y)
+            std::fill(&g.At(r.x0, y, z), &g.At(r.x0, y, z) + (r.x1 - r.x0), 0.0f);
+}
+
+const uint32_t checkpointVersion = 1;
+
+void Put(std::vector<char>& out, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+template <typename T>
+void Put(std::vector<char>& out, const T& value) {
+    Put(out, &value, sizeof(T));
+}
+
+// Bounds-checked cursor over a checkpoint payload
+struct Reader {
+    const std::vector<char>& in;
+    size_t pos = 0;
+
+    bool Get(void* data, size_t size) {
+        if (size > in.size() - pos)
+            return false;
+        std::memcpy(data, in.data() + pos, size);
+        pos += size;
+        return true;
+    }
+
+    template <typename T>
+    bool Get(T& value) { return Get(&value, sizeof(T)); }
+};
+
+}
+
+SmokeSolver::SmokeSolver(int x, int y, int z)
+    : fields(x, y, z), scratch(x, y, z), pressure(x, y, z), divergence(x, y, z),
+      solid(x, y, z), active(x, y, z), previous(x, y, z) {}
+
+void SmokeSolver::SetObstacles(const SdfScene* scene, const Vector3& boxMin, const Vector3& boxMax) {
+    const int X = fields.Width(), Y = fields.Height(), Z = fields.Depth();
+    solid = VoxelGrid<uint8_t>(X, Y, Z);
+    hasObstacles = false;
+    if (!scene || scene->Empty())
+        return;
+
+    const Vector3 extent = boxMax - boxMin;
+    std::atomic<bool> any = false;
+    ParallelFor(Z, [&](int k0, int k1) {
+        bool found = false;
+        for (int k = k0; k < k1; ++k)
+            for (int j = 0; j < Y; ++j)
+                for (int i = 0; i < X; ++i) {
+                    // Voxel centres, as the renderer samples them
+                    Vector3 p(boxMin.x + (i + 0.5f) / X * extent.x, boxMin.y + (j + 0.5f) / Y * extent.y,
+                        boxMin.z + (k + 0.5f) / Z * extent.z);
+                    // Only the sign matters, so nothing past the surface is evaluated
+                    bool inside = scene->Distance(p, 0.0f) < 0.0f;
+                    solid.At(i, j, k) = inside ? 1 : 0;
+                    found |= inside;
+                }
+        if (found)
+            any = true;
+    });
+    hasObstacles = any;
+}
+
+void SmokeSolver::SetObstacles(const VoxelGrid<float>& distance) {
+    const int X = fields.Width(), Y = fields.Height(), Z = fields.Depth();
+    const int W = distance.Width(), H = distance.Height(), D = distance.Depth();
+    solid = VoxelGrid<uint8_t>(X, Y, Z);
+
+    std::atomic<bool> any = false;
+    ParallelFor(Z, [&](int k0, int k1) {
+        bool found = false;
+        for (int k = k0; k < k1; ++k)
+            for (int j = 0; j < Y; ++j)
+                for (int i = 0; i < X; ++i) {
+                    float d = W == X && H == Y && D == Z ? distance.At(i, j, k) :
+                        distance.Sample((i + 0.5f) * W / X - 0.5f, (j + 0.5f) * H / Y - 0.5f, (k + 0.5f) * D / Z - 0.5f);
+                    bool inside = d < 0.0f;
+                    solid.At(i, j, k) = inside ? 1 : 0;
+                    found |= inside;
+                }
+        if (found)
+            any = true;
+    });
+    hasObstacles = any;
+}
+
+void SmokeSolver::Step(float dt) {
+    StepWith(dt, params.pressureIterations);
+}
+
+void SmokeSolver::Advance(float frameDt) {
+    auto start = Clock::now();
+
+    float remaining = frameDt;
+    int substeps = 0;
+    int iterations = params.pressureIterations;
+    bool degraded = false;
+    float startSpeed = -1.0f;
+
+    while (remaining > 0.0f) {
+        // Velocity outside the last active set is zero, so it bounds the search.
+        // Sources set their velocity before the step advects, so count them too
+        float speed = MaxSpeed();
+        for (const SmokeSource& source : sources)
+            speed = std::max(speed, source.velocity.magnitude());
+        if (startSpeed < 0.0f)
+            startSpeed = speed;
+
+        float dt = remaining;
+        if (speed > 0.0f)
+            dt = std::min(dt, params.cfl * params.cellSize / speed);
+        int needed = static_cast<int>(std::ceil(remaining / dt - 1e-4f));
+
+        // Projection dominates the step, so cost scales with iterations
+        double budgetLeft = params.budgetSeconds - SecondsBetween(start, Clock::now());
+        double fixed = stats.stepSeconds - stats.projectSeconds;
+        double perIteration = stats.projectSeconds / std::max(stats.pressureIterations, 1);
+        double estimate = fixed + perIteration * iterations;
+
+        if (stats.steps > 0 && needed * estimate > budgetLeft) {
+            degraded = true;
+            double iterationBudget = budgetLeft / needed - fixed;
+            // The floor never raises iterations, even if it is set above them
+            int affordable = static_cast<int>(iterationBudget / std::max(perIteration, 1e-9));
+            iterations = std::max(std::min(affordable, iterations), std::min(params.minPressureIterations, iterations));
+            estimate = fixed + perIteration * iterations;
+        }
+
+        int allowed = params.maxSubsteps - substeps;
+        if (stats.steps > 0 && estimate > 0.0)
+            allowed = std::min(allowed, static_cast<int>(budgetLeft / estimate));
+        allowed = std::max(allowed, 1);
+        if (needed > allowed) {
+            // Out of budget: cover the rest of the frame in fewer, larger steps
+            degraded = true;
+            dt = remaining / allowed;
+        }
+
+        StepWith(dt, iterations);
+        remaining -= dt;
+        ++substeps;
+        if (remaining <= frameDt * 1e-4f)
+            break;
+    }
+
+    stats.advanceSeconds = SecondsBetween(start, Clock::now());
+    stats.substeps = substeps;
+    stats.maxSpeed = std::max(startSpeed, 0.0f);
+    stats.degraded = degraded;
+}
+
+float SmokeSolver::MaxSpeed() {
+    brickSpeed.assign(activeList.size(), 0.0f);
+    ParallelFor(static_cast<int>(activeList.size()), [&](int begin, int end) {
+        for (int n = begin; n < end; ++n) {
+            BrickRange r = active.Bounds(activeList[n]);
+            float maxSq = 0.0f;
+            for (int k = r.z0; k < r.z1; ++k)
+                for (int j = r.y0; j < r.y1; ++j)
+                    for (int i = r.x0; i < r.x1; ++i) {
+                        float u = fields.u.At(i, j, k), v = fields.v.At(i, j, k), w = fields.w.At(i, j, k);
+                        maxSq = std::max(maxSq, u * u + v * v + w * w);
+                    }
+            brickSpeed[n] = maxSq;
+        }
+    });
+
+    float maxSq = 0.0f;
+    for (float s : brickSpeed)
+        maxSq = std::max(maxSq, s);
+    return std::sqrt(maxSq);
+}
+
+void SmokeSolver::StepWith(float dt, int iterations) {
+    auto t0 = Clock::now();
+
+    UpdateActiveBricks();
+    AddSources(dt);
+    ClearSolids();
+
+    auto t1 = Clock::now();
+    forces.params.cellSize = params.cellSize;
+    forces.Apply(fields, dt, &active);
+
+    auto t2 = Clock::now();
+    Advect(dt);
+    ClearSolids();
+
+    auto t3 = Clock::now();
+    Project(iterations);
+
+    auto t4 = Clock::now();
+    stats.forcesSeconds = SecondsBetween(t1, t2);
+    stats.advectSeconds = SecondsBetween(t2, t3);
+    stats.projectSeconds = SecondsBetween(t3, t4);
+    stats.stepSeconds = SecondsBetween(t0, t4);
+    stats.pressureIterations = iterations;
+    stats.activeBricks = static_cast<int>(activeList.size());
+    stats.totalBricks = active.BrickCount();
+    stats.activeFraction = static_cast<float>(active.ActiveVoxels()) / static_cast<float>(fields.density.Size());
+    stats.steps++;
+}
+
+void SmokeSolver::UpdateActiveBricks() {
+    std::swap(active, previous);
+
+    active.Clear();
+    active.Mark(fields.density, params.densityThreshold);
+    active.Mark(fields.u, params.velocityThreshold);
+    active.Mark(fields.v, params.velocityThreshold);
+    active.Mark(fields.w, params.velocityThreshold);
+    for (const SmokeSource& s : sources) {
+        active.MarkBox(
+            static_cast<int>(std::floor(s.center.x - s.radius)),
+            static_cast<int>(std::floor(s.center.y - s.radius)),
+            static_cast<int>(std::floor(s.center.z - s.radius)),
+            static_cast<int>(std::ceil(s.center.x + s.radius)) + 1,
+            static_cast<int>(std::ceil(s.center.y + s.radius)) + 1,
+            static_cast<int>(std::ceil(s.center.z + s.radius)) + 1);
+    }
+    active.Dilate(params.haloBricks);
+
+    // Bricks leaving the band may still hold sub-threshold values
+    for (int b = 0; b < active.BrickCount(); ++b)
+        if (previous.Test(b) && !active.Test(b))
+            ClearBrick(b);
+
+    active.ActiveList(activeList);
+}
+
+void SmokeSolver::ClearBrick(int brick) {
+    BrickRange r = active.Bounds(brick);
+    for (SmokeFields* f : { &fields, &scratch }) {
+        ZeroRange(f->u, r);
+        ZeroRange(f->v, r);
+        ZeroRange(f->w, r);
+        ZeroRange(f->density, r);
+        ZeroRange(f->temperature, r);
+    }
+    ZeroRange(pressure, r);
+}
+
+// Nothing lives inside obstacles: sources and advection may have put it there
+void SmokeSolver::ClearSolids() {
+    if (!hasObstacles)
+        return;
+    ParallelFor(static_cast<int>(activeList.size()), [&](int begin, int end) {
+        for (int n = begin; n < end; ++n) {
+            BrickRange r = active.Bounds(activeList[n]);
+            for (int k = r.z0; k < r.z1; ++k)
+                for (int j = r.y0; j < r.y1; ++j)
+                    for (int i = r.x0; i < r.x1; ++i) {
+                        if (!solid.At(i, j, k))
+                            continue;
+                        fields.u.At(i, j, k) = 0.0f;
+                        fields.v.At(i, j, k) = 0.0f;
+                        fields.w.At(i, j, k) = 0.0f;
+                        fields.density.At(i, j, k) = 0.0f;
+                        fields.temperature.At(i, j, k) = 0.0f;
+                    }
+        }
+    });
+}
+
+void SmokeSolver::AddSources(float dt) {
+    const int X = fields.Width(), Y = fields.Height(), Z = fields.Depth();
+    for (const SmokeSource& s : sources) {
+        int x0 = std::max(0, static_cast<int>(std::floor(s.center.x - s.radius)));
+        int y0 = std::max(0, static_cast<int>(std::floor(s.center.y - s.radius)));
+        int z0 = std::max(0, static_cast<int>(std::floor(s.center.z - s.radius)));
+        int x1 = std::min(X - 1, static_cast<int>(std::ceil(s.center.x + s.radius)));
+        int y1 = std::min(Y - 1, static_cast<int>(std::ceil(s.center.y + s.radius)));
+        int z1 = std::min(Z - 1, static_cast<int>(std::ceil(s.center.z + s.radius)));
+
+        for (int k = z0; k <= z1; ++k)
+            for (int j = y0; j <= y1; ++j)
+                for (int i = x0; i <= x1; ++i) {
+                    Vector3 d = Vector3(static_cast<float>(i), static_cast<float>(j), static_cast<float>(k)) - s.center;
+                    if (d.dot(d) > s.radius * s.radius)
+                        continue;
+                    float amount = s.density;
+                    if (s.noise > 0.0f)
+                        amount *= 1.0f + s.noise * std::uniform_real_distribution<float>(-1.0f, 1.0f)(rng);
+
+                    float& density = fields.density.At(i, j, k);
+                    float& temperature = fields.temperature.At(i, j, k);
+                    density = std::min(density + amount * dt, amount);
+                    temperature = std::min(temperature + s.temperature * dt, s.temperature);
+                    fields.u.At(i, j, k) = s.velocity.x;
+                    fields.v.At(i, j, k) = s.velocity.y;
+                    fields.w.At(i, j, k) = s.velocity.z;
+                }
+    }
+}
+
+void SmokeSolver::Advect(float dt) {
+    const float scale = dt / params.cellSize;
+    const SmokeFields& src = fields;
+    SmokeFields& dst = scratch;
+
+    ParallelFor(static_cast<int>(activeList.size()), [&](int begin, int end) {
+        for (int n = begin; n < end; ++n) {
+            BrickRange r = active.Bounds(activeList[n]);
+            for (int k = r.z0; k < r.z1; ++k)
+                for (int j = r.y0; j < r.y1; ++j)
+                    for (int i = r.x0; i < r.x1; ++i) {
+                        // Semi-Lagrangian backtrace through the old velocity
+                        float x = i - src.u.At(i, j, k) * scale;
+                        float y = j - src.v.At(i, j, k) * scale;
+                        float z = k - src.w.At(i, j, k) * scale;
+                        dst.u.At(i, j, k) = src.u.Sample(x, y, z);
+                        dst.v.At(i, j, k) = src.v.Sample(x, y, z);
+                        dst.w.At(i, j, k) = src.w.Sample(x, y, z);
+                        dst.density.At(i, j, k) = src.density.Sample(x, y, z);
+                        dst.temperature.At(i, j, k) = src.temperature.Sample(x, y, z);
+                    }
+        }
+    });
+
+    std::swap(fields, scratch);
+}
+
+void SmokeSolver::Project(int iterations) {
+    const int X = fields.Width(), Y = fields.Height(), Z = fields.Depth();
+    const float h = params.cellSize;
+    const int count = static_cast<int>(activeList.size());
+
+    // Domain walls are solid: velocity outside is zero and pressure mirrors
+    // the border voxel. Obstacle voxels act the same way from either side.
+    // Inactive bricks inside the domain hold zero pressure.
+    const bool solids = hasObstacles;
+    auto open = [&](int i, int j, int k) {
+        return !solids || !solid.At(i, j, k);
+    };
+    auto velocityAt = [&](const VoxelGrid<float>& g, int i, int j, int k) {
+        return (i < 0 || j < 0 || k < 0 || i >= X || j >= Y || k >= Z || !open(i, j, k)) ? 0.0f : g.At(i, j, k);
+    };
+
+    ParallelFor(count, [&](int begin, int end) {
+        for (int n = begin; n < end; ++n) {
+            BrickRange r = active.Bounds(activeList[n]);
+            for (int k = r.z0; k < r.z1; ++k)
+                for (int j = r.y0; j < r.y1; ++j)
+                    for (int i = r.x0; i < r.x1; ++i) {
+                        float div =
+                            velocityAt(fields.u, i + 1, j, k) - velocityAt(fields.u, i - 1, j, k) +
+                            velocityAt(fields.v, i, j + 1, k) - velocityAt(fields.v, i, j - 1, k) +
+                            velocityAt(fields.w, i, j, k + 1) - velocityAt(fields.w, i, j, k - 1);
+                        divergence.At(i, j, k) = -0.5f * h * div;
+                    }
+        }
+    });
+
+    // Red-black Gauss-Seidel, warm started from the previous step
+    for (int it = 0; it < iterations; ++it) {
+        for (int color = 0; color < 2; ++color) {
+            ParallelFor(count, [&](int begin, int end) {
+                for (int n = begin; n < end; ++n) {
+                    BrickRange r = active.Bounds(activeList[n]);
+                    for (int k = r.z0; k < r.z1; ++k)
+                        for (int j = r.y0; j < r.y1; ++j)
+                            for (int i = r.x0 + ((r.x0 + j + k + color) & 1); i < r.x1; i += 2) {
+                                if (!open(i, j, k))
+                                    continue;
+                                float sum = divergence.At(i, j, k);
+                                int neighbours = 0;
+                                if (i > 0 && open(i - 1, j, k))     { sum += pressure.At(i - 1, j, k); ++neighbours; }
+                                if (i < X - 1 && open(i + 1, j, k)) { sum += pressure.At(i + 1, j, k); ++neighbours; }
+                                if (j > 0 && open(i, j - 1, k))     { sum += pressure.At(i, j - 1, k); ++neighbours; }
+                                if (j < Y - 1 && open(i, j + 1, k)) { sum += pressure.At(i, j + 1, k); ++neighbours; }
+                                if (k > 0 && open(i, j, k - 1))     { sum += pressure.At(i, j, k - 1); ++neighbours; }
+                                if (k < Z - 1 && open(i, j, k + 1)) { sum += pressure.At(i, j, k + 1); ++neighbours; }
+                                if (neighbours > 0)
+                                    pressure.At(i, j, k) = sum / static_cast<float>(neighbours);
+                            }
+                }
+            });
+        }
+    }
+
+    const float scale = 0.5f / h;
+    ParallelFor(count, [&](int begin, int end) {
+        for (int n = begin; n < end; ++n) {
+            BrickRange r = active.Bounds(activeList[n]);
+            for (int k = r.z0; k < r.z1; ++k)
+                for (int j = r.y0; j < r.y1; ++j)
+                    for (int i = r.x0; i < r.x1; ++i) {
+                        if (!open(i, j, k))
+                            continue;
+                        float p = pressure.At(i, j, k);
+                        float px0 = i > 0 && open(i - 1, j, k) ? pressure.At(i - 1, j, k) : p;
+                        float px1 = i < X - 1 && open(i + 1, j, k) ? pressure.At(i + 1, j, k) : p;
+                        float py0 = j > 0 && open(i, j - 1, k) ? pressure.At(i, j - 1, k) : p;
+                        float py1 = j < Y - 1 && open(i, j + 1, k) ? pressure.At(i, j + 1, k) : p;
+                        float pz0 = k > 0 && open(i, j, k - 1) ? pressure.At(i, j, k - 1) : p;
+                        float pz1 = k < Z - 1 && open(i, j, k + 1) ? pressure.At(i, j, k + 1) : p;
+                        fields.u.At(i, j, k) -= scale * (px1 - px0);
+                        fields.v.At(i, j, k) -= scale * (py1 - py0);
+                        fields.w.At(i, j, k) -= scale * (pz1 - pz0);
+                    }
+        }
+    });
+}
+
+void SmokeSolver::SaveCheckpoint(std::vector<char>& out) const {
+    const int X = fields.Width(), Y = fields.Height(), Z = fields.Depth();
+    out.clear();
+    Put(out, checkpointVersion);
+    Put(out, X);
+    Put(out, Y);
+    Put(out, Z);
+    Put(out, stats.steps);
+
+    std::ostringstream rngState;
+    rngState << rng;
+    std::string rngText = rngState.str();
+    Put(out, static_cast<uint32_t>(rngText.size()));
+    Put(out, rngText.data(), rngText.size());
+
+    for (int b = 0; b < active.BrickCount(); ++b)
+        Put(out, static_cast<uint8_t>(active.Test(b)));
+
+    for (const VoxelGrid<float>* g : { &fields.u, &fields.v, &fields.w, &fields.density, &fields.temperature, &pressure })
+        Put(out, g->Data(), g->Size() * sizeof(float));
+}
+
+bool SmokeSolver::LoadCheckpoint(const std::vector<char>& in) {
+    Reader r = { in };
+    uint32_t version = 0;
+    int X = 0, Y = 0, Z = 0, steps = 0;
+    if (!r.Get(version) || version != checkpointVersion)
+        return false;
+    if (!r.Get(X) || !r.Get(Y) || !r.Get(Z) || !r.Get(steps))
+        return false;
+    if (X != fields.Width() || Y != fields.Height() || Z != fields.Depth())
+        return false;
+
+    // Everything is parsed into temporaries first, so a truncated or corrupt
+    // checkpoint leaves the running state untouched
+    uint32_t rngSize = 0;
+    if (!r.Get(rngSize) || rngSize > in.size() - r.pos)
+        return false;
+    std::string rngText(rngSize, '\0');
+    if (!r.Get(rngText.data(), rngSize))
+        return false;
+    std::mt19937 loadedRng;
+    std::istringstream rngState(rngText);
+    rngState >> loadedRng;
+    if (rngState.fail())
+        return false;
+
+    std::vector<uint8_t> mask(active.BrickCount());
+    if (!r.Get(mask.data(), mask.size()))
+        return false;
+
+    SmokeFields loaded(X, Y, Z);
+    VoxelGrid<float> loadedPressure(X, Y, Z);
+    for (VoxelGrid<float>* g : { &loaded.u, &loaded.v, &loaded.w, &loaded.density, &loaded.temperature, &loadedPressure })
+        if (!r.Get(g->Data(), g->Size() * sizeof(float)))
+            return false;
+
+    fields = std::move(loaded);
+    pressure = std::move(loadedPressure);
+    rng = loadedRng;
+    for (int b = 0; b < active.BrickCount(); ++b)
+        active.Set(b, mask[b] != 0);
+    active.ActiveList(activeList);
+
+    // Scratch only matters through its zeros outside the active set
+    scratch = SmokeFields(X, Y, Z);
+
+    stats = SolverStats();
+    stats.steps = steps;
+    return true;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <random>
+#include <vector>
+#include "BrickMask.hpp"
+#include "SdfScene.hpp"
+#include "SmokeForces.hpp"
+#include "Vector3.hpp"
+
+// Spherical emitter, in voxel coordinates.
+struct SmokeSource {
+    Vector3 center;
+    float radius = 4.0f;
+    float density = 1.0f;
+    float temperature = 1.0f;
+    Vector3 velocity;
+    float noise = 0.0f; // Random per-voxel variation of the injected density, 0..1
+};
+
+struct SolverParams {
+    float densityThreshold = 1e-4f;  // Density that keeps a brick alive
+    float velocityThreshold = 0.05f; // Speed (cells/s) that keeps a brick alive
+    int haloBricks = 1;              // Margin of empty bricks simulated around the smoke
+    int pressureIterations = 40;
+    float cellSize = 1.0f;
+
+    // Advance() substepping
+    float cfl = 2.0f;                // Max cells travelled per substep
+    int maxSubsteps = 8;
+    double budgetSeconds = 0.008;    // Wall-clock budget per Advance() call
+    int minPressureIterations = 8;   // Floor when degrading to fit the budget
+};
+
+struct SolverStats {
+    double stepSeconds = 0.0;
+    double forcesSeconds = 0.0;
+    double advectSeconds = 0.0;
+    double projectSeconds = 0.0;
+    int activeBricks = 0;
+    int totalBricks = 0;
+    float activeFraction = 0.0f; // Active voxels / all voxels
+    int steps = 0;
+
+    // Last Advance() call
+    double advanceSeconds = 0.0;
+    int substeps = 0;
+    int pressureIterations = 0;  // Iterations used by the last substep
+    float maxSpeed = 0.0f;       // Cells/s at the start of the call, sources included
+    bool degraded = false;       // Iterations or substeps were cut to fit the budget
+};
+
+// Stable-fluids smoke solver on a collocated grid that only advects, applies
+// forces and projects inside active bricks. Voxels outside the active set are
+// kept at exactly zero, so bricks can drop in and out without stale data.
+class SmokeSolver {
+public:
+    SmokeSolver(int x, int y, int z);
+
+    SolverParams params;
+    SmokeForces forces;
+    std::vector<SmokeSource> sources;
+
+    // Single step of length dt.
+    void Step(float dt);
+    // Advances by frameDt in CFL-limited substeps. When the substeps would
+    // overrun params.budgetSeconds, pressure iterations are reduced first and then
+    // substeps are made coarser, so the call returns close to the budget.
+    void Advance(float frameDt);
+
+    // Full state (fields, pressure, active bricks, step counter, RNG) for
+    // checkpoint/restart. Restoring into a solver with the same size and
+    // params and taking the same steps reproduces the original bit for bit;
+    // Advance() is only reproducible with a budget that never kicks in.
+    void SaveCheckpoint(std::vector<char>& out) const;
+    bool LoadCheckpoint(const std::vector<char>& in);
+
+    // Solid obstacles from a built `scene`, or none for nullptr. The grid
+    // spans boxMin..boxMax of the scene's space, like the renderer's volume
+    // box. Voxels whose centres are inside a solid hold no smoke and no flow,
+    // and the pressure solve treats their faces like the domain walls.
+    // Obstacles are not part of checkpoints.
+    void SetObstacles(const SdfScene* scene, const Vector3& boxMin, const Vector3& boxMax);
+    // The same from a distance grid baked over the solver's box, e.g. by
+    // SdfBaker; sampled at voxel centres if its size differs.
+    void SetObstacles(const VoxelGrid<float>& distance);
+    bool HasObstacles() const { return hasObstacles; }
+    const VoxelGrid<uint8_t>& Solid() const { return solid; }
+
+    const SmokeFields& Fields() const { return fields; }
+    const BrickMask& ActiveBricks() const { return active; }
+    const SolverStats& LastStats() const { return stats; }
+
+private:
+    void UpdateActiveBricks();
+    void AddSources(float dt);
+    void Advect(float dt);
+    void Project(int iterations);
+    void StepWith(float dt, int iterations);
+    float MaxSpeed();
+    void ClearBrick(int brick);
+    void ClearSolids();
+
+    SmokeFields fields;
+    SmokeFields scratch;
+    VoxelGrid<float> pressure;
+    VoxelGrid<float> divergence;
+    VoxelGrid<uint8_t> solid; // 1 inside an obstacle
+    bool hasObstacles = false;
+
+    BrickMask active;
+    BrickMask previous;
+    std::vector<int> activeList;
+    std::vector<float> brickSpeed;
+    std::mt19937 rng;
+
+    SolverStats stats;
+};
@@ -0,0 +1,188 @@
+#include "TemporalRenderer.hpp"
+#include "ParallelFor.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+// Bilinear lookup of `channels` floats per pixel at continuous pixel coordinates
+void SampleBilinear(const float* data, int channels, int w, int h, float x, float y, float* out) {
+    x = std::clamp(x, 0.0f, w - 1.0f);
+    y = std::clamp(y, 0.0f, h - 1.0f);
+    int x0 = std::min(static_cast<int>(x), std::max(w - 2, 0)), y0 = std::min(static_cast<int>(y), std::max(h - 2, 0));
+    int x1 = std::min(x0 + 1, w - 1), y1 = std::min(y0 + 1, h - 1);
+    float fx = x - x0, fy = y - y0;
+    const float* a = data + (static_cast<size_t>(y0) * w + x0) * channels;
+    const float* b = data + (static_cast<size_t>(y0) * w + x1) * channels;
+    const float* c = data + (static_cast<size_t>(y1) * w + x0) * channels;
+    const float* d = data + (static_cast<size_t>(y1) * w + x1) * channels;
+    for (int ch = 0; ch < channels; ++ch) {
+        float top = a[ch] + (b[ch] - a[ch]) * fx;
+        float bottom = c[ch] + (d[ch] - c[ch]) * fx;
+        out[ch] = top + (bottom - top) * fy;
+    }
+}
+
+// Catmull-Rom lookup of an RGBA image. Unlike bilinear it keeps its
+// sharpness when the history is resampled at sub-pixel offsets frame after
+// frame, which would otherwise blur it.
+void SampleCatmullRom(const CpuImage& image, float x, float y, float out[4]) {
+    const int ix = static_cast<int>(std::floor(x)), iy = static_cast<int>(std::floor(y));
+    auto weights = [](float t, float w[4]) {
+        float t2 = t * t, t3 = t2 * t;
+        w[0] = -0.5f * t3 + t2 - 0.5f * t;
+        w[1] = 1.5f * t3 - 2.5f * t2 + 1.0f;
+        w[2] = -1.5f * t3 + 2.0f * t2 + 0.5f * t;
+        w[3] = 0.5f * t3 - 0.5f * t2;
+    };
+    float wx[4], wy[4];
+    weights(x - ix, wx);
+    weights(y - iy, wy);
+
+    // Clamped tap columns and rows, so the inner loops index without branching
+    int cols[4], rows[4];
+    for (int i = 0; i < 4; ++i) {
+        cols[i] = std::clamp(ix - 1 + i, 0, image.width - 1) * 4;
+        rows[i] = std::clamp(iy - 1 + i, 0, image.height - 1);
+    }
+    out[0] = out[1] = out[2] = out[3] = 0.0f;
+    for (int j = 0; j < 4; ++j) {
+        const float* row = image.rgba.data() + static_cast<size_t>(rows[j]) * image.width * 4;
+        float r[4] = {};
+        for (int i = 0; i < 4; ++i)
+            for (int c = 0; c < 4; ++c)
+                r[c] += row[cols[i] + c] * wx[i];
+        for (int c = 0; c < 4; ++c)
+            out[c] += r[c] * wy[j];
+    }
+}
+
+}
+
+void TemporalRenderer::Reset() {
+    hasHistory = false;
+    frame = 0;
+}
+
+void TemporalRenderer::Render(const VoxelGrid<float>& density, CpuImage& image) {
+    PROFILE_SCOPE("TemporalRenderer::Render");
+    auto start = std::chrono::steady_clock::now();
+
+    const int w = image.width, h = image.height;
+    renderer.settings = settings;
+    renderer.settings.jitterFrame = frame++;
+    if (current.width != w || current.height != h)
+        current.Resize(w, h);
+    renderer.Render(density, current);
+
+    const CameraFrame view = settings.camera.Frame(w, h);
+    if (!hasHistory || history.width != w || history.height != h) {
+        history = current;
+        historyLength.assign(static_cast<size_t>(w) * h, 1.0f);
+        image.rgba = current.rgba;
+        image.depth = current.depth;
+        previous = view;
+        hasHistory = true;
+        stats.reused = 0.0f;
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return;
+    }
+
+    const TemporalSettings t = temporal;
+    nextLength.resize(static_cast<size_t>(w) * h);
+    std::atomic<int> reused = 0;
+
+    ParallelFor(h, [&](int y0, int y1) {
+        int localReused = 0;
+        for (int y = y0; y < y1; ++y) {
+            const float clipY = 1.0f - 2.0f * (y + 0.5f) / h;
+            for (int x = 0; x < w; ++x) {
+                const size_t i = static_cast<size_t>(y) * w + x;
+                const float* cur = current.Pixel(x, y);
+                float* out = image.Pixel(x, y);
+
+                // The new frame's 3x3 neighbourhood: its nearest depth for
+                // the reprojection, and the colour statistics for the clip
+                float depth = current.depth[i];
+                float mean[4] = {}, meanSq[4] = {};
+                float lo[4] = { cur[0], cur[1], cur[2], cur[3] }, hi[4] = { cur[0], cur[1], cur[2], cur[3] };
+                int n = 0;
+                for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, h - 1); ++ny)
+                    for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, w - 1); ++nx) {
+                        depth = std::min(depth, current.depth[static_cast<size_t>(ny) * w + nx]);
+                        const float* p = current.Pixel(nx, ny);
+                        for (int c = 0; c < 4; ++c) {
+                            mean[c] += p[c];
+                            meanSq[c] += p[c] * p[c];
+                            lo[c] = std::min(lo[c], p[c]);
+                            hi[c] = std::max(hi[c], p[c]);
+                        }
+                        n++;
+                    }
+
+                // Where this pixel's content was in the previous frame. The
+                // nearest depth moves edges with the foreground, and is
+                // steadier than the jittered depth alone.
+                const float clipX = 2.0f * (x + 0.5f) / w - 1.0f;
+                Vector3 world = view.position + view.RayDirection(clipX, clipY).normalized() * depth;
+                Vector3 rel = world - previous.position;
+                float z = rel.dot(previous.forward);
+                float hx = 0.0f, hy = 0.0f;
+                bool valid = z > 1e-4f;
+                if (valid) {
+                    float px = rel.dot(previous.right) / (z * previous.tanHalfFovY * previous.aspect);
+                    float py = rel.dot(previous.up) / (z * previous.tanHalfFovY);
+                    hx = (px + 1.0f) * 0.5f * w - 0.5f;
+                    hy = (1.0f - py) * 0.5f * h - 0.5f;
+                    valid = hx >= -0.5f && hx <= w - 0.5f && hy >= -0.5f && hy <= h - 0.5f;
+                }
+
+                // Disocclusion: the history saw something at another depth
+                float past[4], pastDepth, pastLength;
+                if (valid) {
+                    SampleBilinear(history.depth.data(), 1, w, h, hx, hy, &pastDepth);
+                    float expected = rel.magnitude();
+                    valid = std::abs(pastDepth - expected) <= t.depthTolerance * expected;
+                }
+                if (!valid) {
+                    std::copy(cur, cur + 4, out);
+                    nextLength[i] = 1.0f;
+                    continue;
+                }
+                SampleCatmullRom(history, hx, hy, past);
+                SampleBilinear(historyLength.data(), 1, w, h, hx, hy, &pastLength);
+
+                // Variance clip against the new frame's neighbourhood
+                const float length = std::min(std::floor(pastLength) + 1.0f, static_cast<float>(t.maxHistory));
+                const float weight = 1.0f / length;
+                for (int c = 0; c < 4; ++c) {
+                    float m = mean[c] / n;
+                    float sigma = std::sqrt(std::max(meanSq[c] / n - m * m, 0.0f));
+                    // Within the neighbourhood's range, and never excluding
+                    // the new sample itself, which at edges and corners lies
+                    // outside mean +- sigma and would bias the average
+                    float low = std::min(std::max(m - t.clipGamma * sigma, lo[c]), cur[c]);
+                    float high = std::max(std::min(m + t.clipGamma * sigma, hi[c]), cur[c]);
+                    float clipped = std::clamp(past[c], low, high);
+                    out[c] = clipped + (cur[c] - clipped) * weight;
+                }
+                nextLength[i] = length;
+                localReused++;
+            }
+        }
+        reused += localReused;
+    });
+
+    history.rgba = image.rgba;
+    history.depth = current.depth;
+    image.depth = current.depth;
+    historyLength.swap(nextLength);
+    previous = view;
+
+    stats.reused = static_cast<float>(reused) / (static_cast<float>(w) * h);
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include "CpuRenderer.hpp"
+
+struct TemporalSettings {
+    int maxHistory = 4;           // Frames averaged at most; the new frame's weight never drops below 1/maxHistory
+    float clipGamma = 1.0f;       // History is clipped to the neighbourhood mean +- this many standard deviations
+    float depthTolerance = 0.05f; // Relative depth mismatch that discards the history outright
+};
+
+struct TemporalStats {
+    double seconds = 0.0;
+    float reused = 0.0f; // Fraction of pixels that kept some history
+};
+
+// Temporal accumulation over CpuRenderer. Every frame marches each pixel
+// once with a coarse step and a per-pixel jittered start, so consecutive
+// frames sample different points along each ray. The previous result is
+// reprojected through the camera motion using the nearest representative
+// depth around each pixel and blended with the new frame as a running
+// average. History is dropped where it falls off screen or its depth
+// disagrees, and otherwise clipped to the variance and range of the new
+// frame's 3x3 neighbourhood so that changed smoke does not ghost.
+//
+// Accumulation pays only where the coarse step undersamples the smoke: each
+// reprojection resamples the history, which under camera motion costs more
+// than it gains over a well-sampled march. Nor does it recover solid outlines
+// that the coarse sample test misses on thin chords; averaging jittered
+// misses gives partial coverage, not the outline. On the CPU the
+// reprojection itself costs about as much as a march at four times the step,
+// so at equal cost a finer plain march is still the better image.
+class TemporalRenderer {
+public:
+    CpuRenderSettings settings; // stepSize is the per-frame step
+    TemporalSettings temporal;
+
+    // Forgets the history and restarts the jitter sequence, e.g. on a cut.
+    void Reset();
+    // Renders the next frame into `image`, which must keep its size between frames.
+    void Render(const VoxelGrid<float>& density, CpuImage& image);
+
+    const TemporalStats& LastStats() const { return stats; }
+
+private:
+    CpuRenderer renderer;
+    CpuImage current;
+    CpuImage history;
+    std::vector<float> historyLength; // Frames averaged per pixel
+    std::vector<float> nextLength;
+    CameraFrame previous;
+    bool hasHistory = false;
+    int frame = 0;
+
+    TemporalStats stats;
+};
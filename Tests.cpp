@@ -0,0 +1,52 @@
+#include "Tests.hpp"
+
+#include <iostream>
+#include <vector>
+
+namespace {
+
+struct TestCase {
+    const char* name;
+    std::function<void()> body;
+};
+
+std::vector<TestCase>& Registry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+int failures = 0;
+
+}
+
+void Tests::Register(const char* name, const std::function<void()>& body) {
+    Registry().push_back({ name, body });
+}
+
+void Tests::Check(bool ok, const char* expression, const char* file, int line) {
+    if (ok)
+        return;
+    failures++;
+    std::cerr << file << ":" << line << ": CHECK(" << expression << ") failed\n";
+}
+
+int main(int argc, char** argv) {
+    const std::string filter = argc > 1 ? argv[1] : "";
+    int run = 0, failed = 0;
+    for (const TestCase& test : Registry()) {
+        if (!filter.empty() && std::string(test.name).find(filter) == std::string::npos)
+            continue;
+        const int before = failures;
+        test.body();
+        run++;
+        if (failures != before) {
+            failed++;
+            std::cerr << "FAIL " << test.name << "\n";
+        }
+        else {
+            std::cerr << "ok   " << test.name << "\n";
+        }
+    }
+    std::cerr << run - failed << "/" << run << " tests passed\n";
+    return failed == 0 && run > 0 ? 0 : 1;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+// Minimal headless test runner. Each TEST registers itself at static
+// initialisation; Tests.cpp runs them all, or those whose name contains the
+// first command-line argument, and exits non-zero if any CHECK failed.
+namespace Tests {
+
+void Register(const char* name, const std::function<void()>& body);
+void Check(bool ok, const char* expression, const char* file, int line);
+
+struct Registrar {
+    Registrar(const char* name, void (*body)()) { Register(name, body); }
+};
+
+}
+
+#define TEST(name) \
+    static void name(); \
+    static Tests::Registrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(expression) Tests::Check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
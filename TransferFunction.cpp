@@ -0,0 +1,122 @@
+#include "TransferFunction.hpp"
+#include "ParallelFor.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Sub-steps per pre-integrated segment
+const int integrationSteps = 64;
+
+// Linear lookup into a table of `count` four-float entries covering [0, 1]
+void LookupLinear(const std::vector<float>& table, int count, float u, float out[4]) {
+    float x = std::clamp(u, 0.0f, 1.0f) * (count - 1);
+    int i0 = std::min(static_cast<int>(x), count - 2);
+    float f = x - i0;
+    const float* a = &table[i0 * 4];
+    const float* b = a + 4;
+    for (int c = 0; c < 4; ++c)
+        out[c] = a[c] + (b[c] - a[c]) * f;
+}
+
+}
+
+TransferFunction TransferFunction::Default() {
+    TransferFunction tf;
+    tf.points.push_back({ 0.0f, Vector3(0.6f, 0.4f, 0.2f), 0.0f });
+    tf.points.push_back({ 1.0f, Vector3(0.6f, 0.4f, 0.2f), 2.0f });
+    return tf;
+}
+
+void TransferFunction::EvaluatePoints(float density, float rgbe[4]) const {
+    if (sorted.empty()) {
+        rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0.0f;
+        return;
+    }
+
+    auto upper = std::upper_bound(sorted.begin(), sorted.end(), density,
+        [](float d, const TransferPoint& p) { return d < p.density; });
+    const TransferPoint& b = upper == sorted.end() ? sorted.back() : *upper;
+    const TransferPoint& a = upper == sorted.begin() ? sorted.front() : *(upper - 1);
+    float span = b.density - a.density;
+    float t = span > 0.0f ? std::clamp((density - a.density) / span, 0.0f, 1.0f) : 0.0f;
+
+    Vector3 color = a.color + (b.color - a.color) * t;
+    rgbe[0] = color.x;
+    rgbe[1] = color.y;
+    rgbe[2] = color.z;
+    rgbe[3] = a.extinction + (b.extinction - a.extinction) * t;
+}
+
+void TransferFunction::Bake(float length) {
+    // Sort a copy so an editor can keep its own order while dragging stops
+    sorted = points;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const TransferPoint& a, const TransferPoint& b) { return a.density < b.density; });
+    segmentLength = length;
+
+    lut.resize(LutSize * 4);
+    for (int i = 0; i < LutSize; ++i)
+        EvaluatePoints(maxDensity * i / (LutSize - 1), &lut[i * 4]);
+
+    // Front-to-back composite of each segment in small sub-steps through the
+    // 1D table; density varies linearly between the two end samples
+    const int n = PreIntegratedSize;
+    preIntegrated.resize(static_cast<size_t>(n) * n * 4);
+    const float ds = segmentLength / integrationSteps;
+    ParallelFor(n, [&](int b0, int b1) {
+        for (int back = b0; back < b1; ++back)
+            for (int front = 0; front < n; ++front) {
+                float df = static_cast<float>(front) / (n - 1);
+                float db = static_cast<float>(back) / (n - 1);
+                float r = 0.0f, g = 0.0f, bl = 0.0f, transmittance = 1.0f;
+                for (int s = 0; s < integrationSteps; ++s) {
+                    float rgbe[4];
+                    LookupLinear(lut, LutSize, df + (db - df) * (s + 0.5f) / integrationSteps, rgbe);
+                    float alpha = 1.0f - std::exp(-rgbe[3] * ds);
+                    r += transmittance * alpha * rgbe[0];
+                    g += transmittance * alpha * rgbe[1];
+                    bl += transmittance * alpha * rgbe[2];
+                    transmittance *= 1.0f - alpha;
+                }
+                float* out = &preIntegrated[(static_cast<size_t>(back) * n + front) * 4];
+                out[0] = r;
+                out[1] = g;
+                out[2] = bl;
+                out[3] = 1.0f - transmittance;
+            }
+    });
+
+    version++;
+}
+
+void TransferFunction::Evaluate(float density, float rgbe[4]) const {
+    LookupLinear(lut, LutSize, density / maxDensity, rgbe);
+}
+
+void TransferFunction::Segment(float front, float back, float length, float rgba[4]) const {
+    // Bilinear lookup, then rescale from the baked length: alpha compounds as
+    // 1 - (1 - a)^k and the colour keeps its ratio to alpha
+    const int n = PreIntegratedSize;
+    float x = std::clamp(front / maxDensity, 0.0f, 1.0f) * (n - 1);
+    float y = std::clamp(back / maxDensity, 0.0f, 1.0f) * (n - 1);
+    int x0 = std::min(static_cast<int>(x), n - 2), y0 = std::min(static_cast<int>(y), n - 2);
+    float fx = x - x0, fy = y - y0;
+    const float* p00 = &preIntegrated[(static_cast<size_t>(y0) * n + x0) * 4];
+    const float* p01 = p00 + static_cast<size_t>(n) * 4;
+    for (int c = 0; c < 4; ++c) {
+        float top = p00[c] + (p00[c + 4] - p00[c]) * fx;
+        float bottom = p01[c] + (p01[c + 4] - p01[c]) * fx;
+        rgba[c] = top + (bottom - top) * fy;
+    }
+
+    float k = length / segmentLength;
+    if (k == 1.0f)
+        return;
+    float alpha = 1.0f - std::pow(std::max(1.0f - rgba[3], 0.0f), k);
+    float scale = rgba[3] > 1e-6f ? alpha / rgba[3] : k;
+    rgba[0] *= scale;
+    rgba[1] *= scale;
+    rgba[2] *= scale;
+    rgba[3] = alpha;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Vector3.hpp"
+
+// One editable stop of the transfer function. Colour and extinction are
+// interpolated linearly between stops and held flat beyond the end ones.
+struct TransferPoint {
+    float density = 0.0f;
+    Vector3 color;           // Emitted colour
+    float extinction = 0.0f; // Opacity per world unit of path length
+};
+
+// Maps smoke density to colour and extinction for emission-absorption
+// raymarching. Bake() turns the control points into two tables shared by the
+// CPU renderer and the shaders:
+//  - a 1D table of (rgb, extinction) over [0, maxDensity], sampled per step;
+//  - a pre-integrated 2D table holding the composited (premultiplied rgb,
+//    alpha) of a whole segment whose density runs linearly from the front
+//    sample to the back one. Because it integrates everything in between,
+//    steps several times larger than the 1D path needs stay free of banding.
+class TransferFunction {
+public:
+    static constexpr int LutSize = 256;
+    static constexpr int PreIntegratedSize = 128;
+
+    std::vector<TransferPoint> points; // Any order; Bake() sorts a copy
+    float maxDensity = 1.0f;           // Density mapped to the last table entry
+
+    // Brown smoke, roughly the tint of the original shader.
+    static TransferFunction Default();
+
+    // Rebuilds both tables. The 2D table is integrated for segments of
+    // `segmentLength` world units; other lengths are rescaled at lookup.
+    void Bake(float segmentLength);
+    // Bumped by every Bake(), so GPU copies know when to re-upload.
+    uint64_t Version() const { return version; }
+
+    // LutSize entries of r, g, b, extinction.
+    const std::vector<float>& Lut() const { return lut; }
+    // PreIntegratedSize^2 entries of r, g, b, alpha, front density along x.
+    const std::vector<float>& PreIntegrated() const { return preIntegrated; }
+    float SegmentLength() const { return segmentLength; }
+
+    // Interpolated 1D table entry for `density`.
+    void Evaluate(float density, float rgbe[4]) const;
+    // Composited segment from `front` to `back` density over `length`.
+    void Segment(float front, float back, float length, float rgba[4]) const;
+
+private:
+    void EvaluatePoints(float density, float rgbe[4]) const;
+
+    std::vector<TransferPoint> sorted;
+    std::vector<float> lut;
+    std::vector<float> preIntegrated;
+    float segmentLength = 1.0f;
+    uint64_t version = 0;
+};
@@ -4,40 +4,142 @@
 #include <cmath>
 #include <iostream>
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VECTOR3_SSE2 1
+#endif
+
+// Everything is inline so hot loops in other translation units can fold the
+// arithmetic into registers instead of calling out for each operator.
 class Vector3 {
 public:
     float x, y, z;
 
     // Constructors
-    Vector3();
-    Vector3(float x, float y, float z);
+    constexpr Vector3() : x(0), y(0), z(0) {}
+    constexpr Vector3(float x, float y, float z) : x(x), y(y), z(z) {}
 
     // Magnitude and Normalization
-    float magnitude() const;
-    Vector3 normalized() const;
+    float magnitude() const { return std::sqrt(dot(*this)); }
+    // Zero-length vectors normalize to zero
+    Vector3 normalized() const {
+        float mag = magnitude();
+        return (mag > 0) ? (*this / mag) : Vector3(0, 0, 0);
+    }
 
     // Dot and Cross Product
-    float dot(const Vector3& other) const;
-    Vector3 cross(const Vector3& other) const;
+    constexpr float dot(const Vector3& other) const { return x * other.x + y * other.y + z * other.z; }
+    constexpr Vector3 cross(const Vector3& other) const {
+        return Vector3(y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x);
+    }
 
     // Operators
-    Vector3 operator+(const Vector3& other) const;
-    Vector3 operator-(const Vector3& other) const;
-    Vector3 operator*(float scalar) const;
-    Vector3 operator/(float scalar) const;
+    constexpr Vector3 operator+(const Vector3& other) const { return Vector3(x + other.x, y + other.y, z + other.z); }
+    constexpr Vector3 operator-(const Vector3& other) const { return Vector3(x - other.x, y - other.y, z - other.z); }
+    constexpr Vector3 operator*(float scalar) const { return Vector3(x * scalar, y * scalar, z * scalar); }
+    // No zero check: dividing by zero gives infinities like any float division
+    constexpr Vector3 operator/(float scalar) const { return Vector3(x / scalar, y / scalar, z / scalar); }
 
     // Compound Assignment
-    Vector3& operator+=(const Vector3& other);
-    Vector3& operator-=(const Vector3& other);
-    Vector3& operator*=(float scalar);
-    Vector3& operator/=(float scalar);
+    constexpr Vector3& operator+=(const Vector3& other) { return *this = *this + other; }
+    constexpr Vector3& operator-=(const Vector3& other) { return *this = *this - other; }
+    constexpr Vector3& operator*=(float scalar) { return *this = *this * scalar; }
+    constexpr Vector3& operator/=(float scalar) { return *this = *this / scalar; }
 
     // Comparison
-    bool operator==(const Vector3& other) const;
-    bool operator!=(const Vector3& other) const;
+    constexpr bool operator==(const Vector3& other) const { return x == other.x && y == other.y && z == other.z; }
+    constexpr bool operator!=(const Vector3& other) const { return !(*this == other); }
 
     // Print
-    void print() const;
+    void print() const { std::cout << "(" << x << ", " << y << ", " << z << ")\n"; }
+};
+
+// Vector3 padded to four floats and kept in an SSE register where available.
+// The fourth lane is always zero so it never leaks into dot or magnitude.
+// Meant for short-lived values in hot loops; store as Vector3 or Vector3Array.
+class alignas(16) Vector3A {
+public:
+#ifdef VECTOR3_SSE2
+    Vector3A() : v(_mm_setzero_ps()) {}
+    Vector3A(float x, float y, float z) : v(_mm_set_ps(0.0f, z, y, x)) {}
+    explicit Vector3A(__m128 v) : v(v) {}
+#else
+    Vector3A() : v{ 0.0f, 0.0f, 0.0f, 0.0f } {}
+    Vector3A(float x, float y, float z) : v{ x, y, z, 0.0f } {}
+#endif
+    explicit Vector3A(const Vector3& a) : Vector3A(a.x, a.y, a.z) {}
+
+    float X() const { return Lane(0); }
+    float Y() const { return Lane(1); }
+    float Z() const { return Lane(2); }
+    Vector3 ToVector3() const { return Vector3(X(), Y(), Z()); }
+
+#ifdef VECTOR3_SSE2
+    Vector3A operator+(const Vector3A& o) const { return Vector3A(_mm_add_ps(v, o.v)); }
+    Vector3A operator-(const Vector3A& o) const { return Vector3A(_mm_sub_ps(v, o.v)); }
+    Vector3A operator*(float s) const { return Vector3A(_mm_mul_ps(v, _mm_set1_ps(s))); }
+    Vector3A operator/(float s) const { return Vector3A(_mm_div_ps(v, _mm_set_ps(1.0f, s, s, s))); }
+    // Component-wise
+    Vector3A operator*(const Vector3A& o) const { return Vector3A(_mm_mul_ps(v, o.v)); }
+
+    float dot(const Vector3A& o) const {
+        __m128 m = _mm_mul_ps(v, o.v);
+        __m128 s = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+        s = _mm_add_ss(s, _mm_movehl_ps(s, s));
+        return _mm_cvtss_f32(s);
+    }
+    Vector3A cross(const Vector3A& o) const {
+        // (y z x) * (o.z o.x o.y) - (z x y) * (o.y o.z o.x), w stays 0
+        __m128 a = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 b = _mm_shuffle_ps(o.v, o.v, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 c = _mm_sub_ps(_mm_mul_ps(v, b), _mm_mul_ps(a, o.v));
+        return Vector3A(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+    }
+    static Vector3A Min(const Vector3A& a, const Vector3A& b) { return Vector3A(_mm_min_ps(a.v, b.v)); }
+    static Vector3A Max(const Vector3A& a, const Vector3A& b) { return Vector3A(_mm_max_ps(a.v, b.v)); }
+#else
+    Vector3A operator+(const Vector3A& o) const { return Vector3A(v[0] + o.v[0], v[1] + o.v[1], v[2] + o.v[2]); }
+    Vector3A operator-(const Vector3A& o) const { return Vector3A(v[0] - o.v[0], v[1] - o.v[1], v[2] - o.v[2]); }
+    Vector3A operator*(float s) const { return Vector3A(v[0] * s, v[1] * s, v[2] * s); }
+    Vector3A operator/(float s) const { return Vector3A(v[0] / s, v[1] / s, v[2] / s); }
+    Vector3A operator*(const Vector3A& o) const { return Vector3A(v[0] * o.v[0], v[1] * o.v[1], v[2] * o.v[2]); }
+
+    float dot(const Vector3A& o) const { return v[0] * o.v[0] + v[1] * o.v[1] + v[2] * o.v[2]; }
+    Vector3A cross(const Vector3A& o) const { return Vector3A(ToVector3().cross(o.ToVector3())); }
+    static Vector3A Min(const Vector3A& a, const Vector3A& b) {
+        return Vector3A(std::fmin(a.v[0], b.v[0]), std::fmin(a.v[1], b.v[1]), std::fmin(a.v[2], b.v[2]));
+    }
+    static Vector3A Max(const Vector3A& a, const Vector3A& b) {
+        return Vector3A(std::fmax(a.v[0], b.v[0]), std::fmax(a.v[1], b.v[1]), std::fmax(a.v[2], b.v[2]));
+    }
+#endif
+
+    Vector3A& operator+=(const Vector3A& o) { return *this = *this + o; }
+    Vector3A& operator-=(const Vector3A& o) { return *this = *this - o; }
+    Vector3A& operator*=(float s) { return *this = *this * s; }
+
+    float magnitude() const { return std::sqrt(dot(*this)); }
+    Vector3A normalized() const {
+        float mag = magnitude();
+        return (mag > 0) ? (*this / mag) : Vector3A();
+    }
+
+private:
+    float Lane(int i) const {
+#ifdef VECTOR3_SSE2
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, v);
+        return lanes[i];
+#else
+        return v[i];
+#endif
+    }
+
+#ifdef VECTOR3_SSE2
+    __m128 v;
+#else
+    float v[4];
+#endif
 };
 
 #endif // VECTOR3_HPP
@@ -0,0 +1,100 @@
+#include "Vector3Array.hpp"
+
+#include <cmath>
+
+// Each kernel runs four lanes at a time with unaligned loads (std::vector
+// storage is not guaranteed 16-byte aligned), then finishes the tail with
+// the scalar form of the same expression.
+
+void Dot(const Vector3Array& a, const Vector3Array& b, float* out, size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef VECTOR3_SSE2
+    for (; i + 4 <= end; i += 4) {
+        __m128 d = _mm_mul_ps(_mm_loadu_ps(&a.x[i]), _mm_loadu_ps(&b.x[i]));
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(&a.y[i]), _mm_loadu_ps(&b.y[i])));
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(&a.z[i]), _mm_loadu_ps(&b.z[i])));
+        _mm_storeu_ps(out + i, d);
+    }
+#endif
+    for (; i < end; ++i)
+        out[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+}
+
+void Cross(const Vector3Array& a, const Vector3Array& b, Vector3Array& out, size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef VECTOR3_SSE2
+    for (; i + 4 <= end; i += 4) {
+        __m128 ax = _mm_loadu_ps(&a.x[i]), ay = _mm_loadu_ps(&a.y[i]), az = _mm_loadu_ps(&a.z[i]);
+        __m128 bx = _mm_loadu_ps(&b.x[i]), by = _mm_loadu_ps(&b.y[i]), bz = _mm_loadu_ps(&b.z[i]);
+        _mm_storeu_ps(&out.x[i], _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by)));
+        _mm_storeu_ps(&out.y[i], _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz)));
+        _mm_storeu_ps(&out.z[i], _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx)));
+    }
+#endif
+    for (; i < end; ++i) {
+        float ax = a.x[i], ay = a.y[i], az = a.z[i];
+        float bx = b.x[i], by = b.y[i], bz = b.z[i];
+        out.x[i] = ay * bz - az * by;
+        out.y[i] = az * bx - ax * bz;
+        out.z[i] = ax * by - ay * bx;
+    }
+}
+
+void Normalize(Vector3Array& a, size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef VECTOR3_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 4 <= end; i += 4) {
+        __m128 x = _mm_loadu_ps(&a.x[i]), y = _mm_loadu_ps(&a.y[i]), z = _mm_loadu_ps(&a.z[i]);
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        // Full-precision sqrt and divide; zero lanes get a zero scale
+        __m128 inv = _mm_and_ps(_mm_cmpgt_ps(len2, zero), _mm_div_ps(one, _mm_sqrt_ps(len2)));
+        _mm_storeu_ps(&a.x[i], _mm_mul_ps(x, inv));
+        _mm_storeu_ps(&a.y[i], _mm_mul_ps(y, inv));
+        _mm_storeu_ps(&a.z[i], _mm_mul_ps(z, inv));
+    }
+#endif
+    for (; i < end; ++i) {
+        float len2 = a.x[i] * a.x[i] + a.y[i] * a.y[i] + a.z[i] * a.z[i];
+        float inv = len2 > 0.0f ? 1.0f / std::sqrt(len2) : 0.0f;
+        a.x[i] *= inv;
+        a.y[i] *= inv;
+        a.z[i] *= inv;
+    }
+}
+
+void Lerp(const Vector3Array& a, const Vector3Array& b, float t, Vector3Array& out, size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef VECTOR3_SSE2
+    const __m128 vt = _mm_set1_ps(t);
+    for (; i + 4 <= end; i += 4) {
+        __m128 ax = _mm_loadu_ps(&a.x[i]), ay = _mm_loadu_ps(&a.y[i]), az = _mm_loadu_ps(&a.z[i]);
+        _mm_storeu_ps(&out.x[i], _mm_add_ps(ax, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&b.x[i]), ax), vt)));
+        _mm_storeu_ps(&out.y[i], _mm_add_ps(ay, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&b.y[i]), ay), vt)));
+        _mm_storeu_ps(&out.z[i], _mm_add_ps(az, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&b.z[i]), az), vt)));
+    }
+#endif
+    for (; i < end; ++i) {
+        out.x[i] = a.x[i] + (b.x[i] - a.x[i]) * t;
+        out.y[i] = a.y[i] + (b.y[i] - a.y[i]) * t;
+        out.z[i] = a.z[i] + (b.z[i] - a.z[i]) * t;
+    }
+}
+
+void AddScaled(const Vector3Array& a, const Vector3Array& b, float s, Vector3Array& out, size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef VECTOR3_SSE2
+    const __m128 vs = _mm_set1_ps(s);
+    for (; i + 4 <= end; i += 4) {
+        _mm_storeu_ps(&out.x[i], _mm_add_ps(_mm_loadu_ps(&a.x[i]), _mm_mul_ps(_mm_loadu_ps(&b.x[i]), vs)));
+        _mm_storeu_ps(&out.y[i], _mm_add_ps(_mm_loadu_ps(&a.y[i]), _mm_mul_ps(_mm_loadu_ps(&b.y[i]), vs)));
+        _mm_storeu_ps(&out.z[i], _mm_add_ps(_mm_loadu_ps(&a.z[i]), _mm_mul_ps(_mm_loadu_ps(&b.z[i]), vs)));
+    }
+#endif
+    for (; i < end; ++i) {
+        out.x[i] = a.x[i] + b.x[i] * s;
+        out.y[i] = a.y[i] + b.y[i] * s;
+        out.z[i] = a.z[i] + b.z[i] * s;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "Vector3.hpp"
+
+// Structure-of-arrays storage for many vectors: one contiguous array per
+// component, so batched operations run four (SSE) elements per instruction
+// with no shuffling. Get/Set convert single elements to and from Vector3.
+class Vector3Array {
+public:
+    explicit Vector3Array(size_t count = 0) { Resize(count); }
+
+    void Resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+    }
+    void Clear() { Resize(0); }
+    size_t Size() const { return x.size(); }
+
+    void Push(const Vector3& v) {
+        x.push_back(v.x);
+        y.push_back(v.y);
+        z.push_back(v.z);
+    }
+    Vector3 Get(size_t i) const { return Vector3(x[i], y[i], z[i]); }
+    void Set(size_t i, const Vector3& v) {
+        x[i] = v.x;
+        y[i] = v.y;
+        z[i] = v.z;
+    }
+
+    std::vector<float> x, y, z;
+};
+
+// Batched kernels over [begin, end); the whole-array forms cover every
+// element. Outputs may alias inputs. Arrays must be at least `end` long.
+void Dot(const Vector3Array& a, const Vector3Array& b, float* out, size_t begin, size_t end);
+void Cross(const Vector3Array& a, const Vector3Array& b, Vector3Array& out, size_t begin, size_t end);
+// Zero-length vectors stay zero, as with Vector3::normalized
+void Normalize(Vector3Array& a, size_t begin, size_t end);
+void Lerp(const Vector3Array& a, const Vector3Array& b, float t, Vector3Array& out, size_t begin, size_t end);
+// out[i] = a[i] + b[i] * s, the advection and ray-march step
+void AddScaled(const Vector3Array& a, const Vector3Array& b, float s, Vector3Array& out, size_t begin, size_t end);
+
+inline void Dot(const Vector3Array& a, const Vector3Array& b, float* out) { Dot(a, b, out, 0, a.Size()); }
+inline void Cross(const Vector3Array& a, const Vector3Array& b, Vector3Array& out) { Cross(a, b, out, 0, a.Size()); }
+inline void Normalize(Vector3Array& a) { Normalize(a, 0, a.Size()); }
+inline void Lerp(const Vector3Array& a, const Vector3Array& b, float t, Vector3Array& out) { Lerp(a, b, t, out, 0, a.Size()); }
+inline void AddScaled(const Vector3Array& a, const Vector3Array& b, float s, Vector3Array& out) { AddScaled(a, b, s, out, 0, a.Size()); }
@@ -0,0 +1,129 @@
+#include "Tests.hpp"
+#include "Vector3Array.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace {
+
+// Lengths around the four-lane width, so some leave a scalar tail
+const size_t lengths[] = { 0, 1, 3, 4, 5, 7, 8, 13, 64, 67 };
+
+Vector3Array RandomArray(size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(-2.0f, 2.0f);
+    Vector3Array a(count);
+    for (size_t i = 0; i < count; ++i)
+        a.Set(i, Vector3(unit(rng), unit(rng), unit(rng)));
+    return a;
+}
+
+// Within rounding of the scalar form, which may order or fuse operations differently
+bool Near(float a, float b) {
+    return std::abs(a - b) <= 1e-6f * std::max(1.0f, std::abs(b));
+}
+
+bool Near(const Vector3& a, const Vector3& b) {
+    return Near(a.x, b.x) && Near(a.y, b.y) && Near(a.z, b.z);
+}
+
+// Sub-ranges of `n` elements: the whole array and one offset from both ends
+std::vector<std::pair<size_t, size_t>> Ranges(size_t n) {
+    std::vector<std::pair<size_t, size_t>> ranges = { { 0, n } };
+    if (n >= 3)
+        ranges.push_back({ 1, n - 1 });
+    return ranges;
+}
+
+}
+
+TEST(Vector3ArrayDot) {
+    for (size_t n : lengths) {
+        const Vector3Array a = RandomArray(n, 1), b = RandomArray(n, 2);
+        for (auto [begin, end] : Ranges(n)) {
+            std::vector<float> out(n, -7.0f);
+            Dot(a, b, out.data(), begin, end);
+            for (size_t i = 0; i < n; ++i)
+                CHECK(begin <= i && i < end ? Near(out[i], a.Get(i).dot(b.Get(i))) : out[i] == -7.0f);
+        }
+    }
+}
+
+TEST(Vector3ArrayCross) {
+    for (size_t n : lengths) {
+        const Vector3Array a = RandomArray(n, 1), b = RandomArray(n, 2);
+        for (auto [begin, end] : Ranges(n)) {
+            Vector3Array out = RandomArray(n, 3);
+            const Vector3Array before = out;
+            Cross(a, b, out, begin, end);
+            for (size_t i = 0; i < n; ++i)
+                CHECK(begin <= i && i < end ? Near(out.Get(i), a.Get(i).cross(b.Get(i))) : out.Get(i) == before.Get(i));
+        }
+        // Output aliasing the first input
+        Vector3Array c = a;
+        Cross(c, b, c);
+        for (size_t i = 0; i < n; ++i)
+            CHECK(Near(c.Get(i), a.Get(i).cross(b.Get(i))));
+    }
+}
+
+TEST(Vector3ArrayNormalize) {
+    for (size_t n : lengths) {
+        const Vector3Array a = RandomArray(n, 1);
+        for (auto [begin, end] : Ranges(n)) {
+            Vector3Array out = a;
+            Normalize(out, begin, end);
+            for (size_t i = 0; i < n; ++i)
+                CHECK(Near(out.Get(i), begin <= i && i < end ? a.Get(i).normalized() : a.Get(i)));
+        }
+    }
+    // Zero-length vectors in the vector lanes and in the tail stay zero
+    Vector3Array z = RandomArray(7, 4);
+    z.Set(1, Vector3());
+    z.Set(6, Vector3());
+    Normalize(z);
+    CHECK(z.Get(1) == Vector3() && z.Get(6) == Vector3());
+    CHECK(Near(z.Get(0).magnitude(), 1.0f) && Near(z.Get(5).magnitude(), 1.0f));
+}
+
+TEST(Vector3ArrayLerpAndAddScaled) {
+    for (size_t n : lengths) {
+        const Vector3Array a = RandomArray(n, 1), b = RandomArray(n, 2);
+        for (auto [begin, end] : Ranges(n)) {
+            Vector3Array lerp = RandomArray(n, 3), added = lerp;
+            const Vector3Array before = lerp;
+            Lerp(a, b, 0.3f, lerp, begin, end);
+            AddScaled(a, b, -1.5f, added, begin, end);
+            for (size_t i = 0; i < n; ++i) {
+                const bool inside = begin <= i && i < end;
+                CHECK(inside ? Near(lerp.Get(i), a.Get(i) + (b.Get(i) - a.Get(i)) * 0.3f) : lerp.Get(i) == before.Get(i));
+                CHECK(inside ? Near(added.Get(i), a.Get(i) + b.Get(i) * -1.5f) : added.Get(i) == before.Get(i));
+            }
+        }
+        // Output aliasing the second input
+        Vector3Array lerp = b, added = b;
+        Lerp(a, lerp, 0.3f, lerp);
+        AddScaled(a, added, -1.5f, added);
+        for (size_t i = 0; i < n; ++i) {
+            CHECK(Near(lerp.Get(i), a.Get(i) + (b.Get(i) - a.Get(i)) * 0.3f));
+            CHECK(Near(added.Get(i), a.Get(i) + b.Get(i) * -1.5f));
+        }
+    }
+}
+
+TEST(Vector3AMatchesVector3) {
+    const Vector3Array a = RandomArray(64, 1), b = RandomArray(64, 2);
+    for (size_t i = 0; i < a.Size(); ++i) {
+        const Vector3 u = a.Get(i), v = b.Get(i);
+        const Vector3A ua(u), va(v);
+        CHECK(Near(ua.dot(va), u.dot(v)));
+        CHECK(Near(ua.cross(va).ToVector3(), u.cross(v)));
+        CHECK(Near(ua.normalized().ToVector3(), u.normalized()));
+        CHECK(Near((ua + va * 0.5f).ToVector3(), u + v * 0.5f));
+    }
+    // The padding lane stays zero through cross, so it never reaches dot
+    const Vector3A c = Vector3A(1.0f, 2.0f, 3.0f).cross(Vector3A(4.0f, 5.0f, 6.0f));
+    CHECK(c.ToVector3() == Vector3(-3.0f, 6.0f, -3.0f));
+    CHECK(c.dot(c) == 54.0f);
+    CHECK(Vector3A().normalized().ToVector3() == Vector3());
+}
@@ -0,0 +1,106 @@
+#include "VolumeRing.hpp"
+
+void VolumeRing::Reset(IVolumeDevice& device) {
+    slots.clear();
+    slots.resize(device.SlotCount());
+    uploads.Invalidate();
+    bound = -1;
+    hasShown = false;
+    clock = 0;
+}
+
+int VolumeRing::Find(int64_t key) const {
+    for (int i = 0; i < static_cast<int>(slots.size()); ++i)
+        if (slots[i].valid && slots[i].key == key)
+            return i;
+    return -1;
+}
+
+bool VolumeRing::Wanted(const Slot& slot) const {
+    return slot.valid && hasShown && slot.key >= shownKey && slot.key < shownKey + lookahead;
+}
+
+int VolumeRing::PickVictim(IVolumeDevice& device, bool mayStall) {
+    // Least recently used idle slot outside the window, else (for Show) any
+    // slot but the bound one, accepting that the upload may wait on the GPU
+    int best = -1;
+    for (int i = 0; i < static_cast<int>(slots.size()); ++i) {
+        if (i == bound || Wanted(slots[i]) || !device.Idle(i))
+            continue;
+        if (!slots[i].valid)
+            return i;
+        if (best < 0 || slots[i].lastUse < slots[best].lastUse)
+            best = i;
+    }
+    if (best >= 0 || !mayStall)
+        return best;
+
+    for (int i = 0; i < static_cast<int>(slots.size()); ++i) {
+        if (i == bound && slots.size() > 1)
+            continue;
+        if (best < 0 || slots[i].lastUse < slots[best].lastUse)
+            best = i;
+    }
+    if (best >= 0)
+        stats.stalls++;
+    return best;
+}
+
+bool VolumeRing::Fill(IVolumeDevice& device, int slot, const VoxelGrid<float>& frame, int64_t key) {
+    Slot& s = slots[slot];
+    s.valid = false;
+    if (!uploads.Upload(device.Slot(slot), frame, key))
+        return false;
+
+    s.valid = true;
+    s.key = key;
+    s.lastUse = ++clock;
+    return true;
+}
+
+bool VolumeRing::Prefetch(IVolumeDevice& device, const VoxelGrid<float>& frame, int64_t key) {
+    if (slots.size() != static_cast<size_t>(device.SlotCount()))
+        Reset(device);
+
+    if (Find(key) >= 0)
+        return true;
+
+    int slot = PickVictim(device, false);
+    if (slot < 0 || !Fill(device, slot, frame, key))
+        return false;
+
+    stats.prefetches++;
+    return true;
+}
+
+int VolumeRing::Show(IVolumeDevice& device, const VoxelGrid<float>& frame, int64_t key) {
+    if (slots.size() != static_cast<size_t>(device.SlotCount()))
+        Reset(device);
+
+    // Move the window first so the victim is chosen relative to this frame
+    hasShown = true;
+    shownKey = key;
+
+    int slot = Find(key);
+    if (slot >= 0) {
+        stats.hits++;
+    }
+    else {
+        slot = PickVictim(device, true);
+        if (slot < 0 || !Fill(device, slot, frame, key))
+            return -1;
+        stats.misses++;
+    }
+
+    slots[slot].lastUse = ++clock;
+    if (slot != bound) {
+        device.Bind(slot);
+        bound = slot;
+    }
+    return slot;
+}
+
+void VolumeRing::EndFrame(IVolumeDevice& device) {
+    if (bound >= 0)
+        device.Fence(bound);
+}
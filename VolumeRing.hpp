@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "VolumeUpload.hpp"
+
+// A set of volume textures the renderer can draw from, plus a way to tell
+// when the GPU has finished with each. Kept free of D3D types so the ring
+// scheduling can be driven by a fake device with simulated latency.
+class IVolumeDevice {
+public:
+    virtual ~IVolumeDevice() = default;
+
+    virtual int SlotCount() const = 0;
+    virtual IVolumeUploadTarget& Slot(int slot) = 0;
+
+    // Makes `slot` the volume the next draw reads.
+    virtual void Bind(int slot) = 0;
+    // Marks the end of GPU work reading `slot` (an event query in D3D11).
+    virtual void Fence(int slot) = 0;
+    // True once every fenced read of `slot` has completed. Must not block.
+    virtual bool Idle(int slot) = 0;
+};
+
+struct VolumeRingStats {
+    uint64_t hits = 0;       // Shown frame was already resident
+    uint64_t misses = 0;     // Shown frame had to be uploaded on the spot
+    uint64_t stalls = 0;     // ...into a slot the GPU might still be reading
+    uint64_t prefetches = 0; // Frames uploaded ahead of being shown
+};
+
+// Rotates uploads across the device's slots so writing the next frame never
+// targets the texture the GPU is drawing from. Frames expected soon can be
+// uploaded ahead with Prefetch while the current one is on screen.
+class VolumeRing {
+public:
+    // Forget what every slot holds, e.g. after the device was recreated.
+    void Reset(IVolumeDevice& device);
+
+    // Uploads `frame` into an idle slot if it is not resident yet. Never
+    // evicts the shown frame or frames in the lookahead window, and never
+    // waits on the GPU; returns false if there was no slot to spare.
+    bool Prefetch(IVolumeDevice& device, const VoxelGrid<float>& frame, int64_t key);
+
+    // Binds the slot holding `frame`, uploading it first if needed.
+    // Returns the bound slot, or -1 if the upload failed.
+    int Show(IVolumeDevice& device, const VoxelGrid<float>& frame, int64_t key);
+
+    // Call after the draw that reads the shown slot has been issued.
+    void EndFrame(IVolumeDevice& device);
+
+    // Keys in [shown, shown + lookahead) are kept resident once uploaded.
+    int lookahead = 2;
+
+    const VolumeRingStats& Stats() const { return stats; }
+    // Uploads into every slot go through this one scheduler, which keeps a
+    // single CPU copy for brick diffs however deep the ring is.
+    const VolumeUploadScheduler& Uploads() const { return uploads; }
+
+private:
+    struct Slot {
+        bool valid = false;
+        int64_t key = 0;
+        uint64_t lastUse = 0;
+    };
+
+    int Find(int64_t key) const;
+    bool Wanted(const Slot& slot) const;
+    int PickVictim(IVolumeDevice& device, bool mayStall);
+    bool Fill(IVolumeDevice& device, int slot, const VoxelGrid<float>& frame, int64_t key);
+
+    std::vector<Slot> slots;
+    VolumeUploadScheduler uploads;
+    int bound = -1;
+    bool hasShown = false;
+    int64_t shownKey = 0;
+    uint64_t clock = 0;
+    VolumeRingStats stats;
+};
@@ -0,0 +1,136 @@
+#include "FakeVolume.hpp"
+#include "Tests.hpp"
+#include "VolumeRing.hpp"
+
+namespace {
+
+// Frames that differ everywhere, or (sparse) in one voxel each
+std::vector<VoxelGrid<float>> Sequence(int count, bool sparse) {
+    std::vector<VoxelGrid<float>> frames;
+    for (int f = 0; f < count; ++f) {
+        if (sparse && f > 0) {
+            frames.push_back(frames.back());
+            frames.back().At(f % 16, f / 16 % 16, 3) += 1.0f;
+        }
+        else {
+            frames.push_back(TestVolume(16, 16, 16, f));
+        }
+    }
+    return frames;
+}
+
+// Slots whose contents are frame `key`
+int Resident(const FakeVolumeDevice& device, const std::vector<VoxelGrid<float>>& frames, int key) {
+    int count = 0;
+    for (const auto& target : device.targets)
+        count += SameVoxels(target->contents, frames[key]) ? 1 : 0;
+    return count;
+}
+
+// One display frame the way Game::Render drives the ring: show, draw,
+// fence, then upload the next frames while the draw is in flight
+void Present(VolumeRing& ring, FakeVolumeDevice& device, const std::vector<VoxelGrid<float>>& frames, int key) {
+    int slot = ring.Show(device, frames[key], key);
+    CHECK(slot >= 0);
+    CHECK(slot == device.bound);
+    CHECK(slot >= 0 && SameVoxels(device.targets[slot]->contents, frames[key]));
+    ring.EndFrame(device);
+
+    for (int k = 1; k < ring.lookahead; ++k)
+        if (key + k >= static_cast<int>(frames.size()) || !ring.Prefetch(device, frames[key + k], key + k))
+            break;
+    device.Tick();
+}
+
+}
+
+TEST(RingSteadyPlayback) {
+    // Enough slots for the frames the GPU still reads plus the lookahead:
+    // after the first frame every shown frame was uploaded ahead
+    for (bool sparse : { false, true }) {
+        std::vector<VoxelGrid<float>> frames = Sequence(40, sparse);
+        FakeVolumeDevice device(4, 2, 16, 16, 16);
+        VolumeRing ring;
+        ring.lookahead = 2;
+        ring.Reset(device);
+        for (int f = 0; f < 40; ++f)
+            Present(ring, device, frames, f);
+
+        CHECK(device.inFlightWrites == 0);
+        CHECK(ring.Stats().stalls == 0);
+        CHECK(ring.Stats().misses == 1);
+        CHECK(ring.Stats().hits == 39);
+    }
+}
+
+TEST(RingUploadAheadDepth) {
+    // After presenting frame k, frames k .. k + lookahead - 1 are resident
+    for (int lookahead = 1; lookahead <= 4; ++lookahead) {
+        std::vector<VoxelGrid<float>> frames = Sequence(30, false);
+        const int latency = 2;
+        FakeVolumeDevice device(lookahead + latency, latency, 16, 16, 16);
+        VolumeRing ring;
+        ring.lookahead = lookahead;
+        ring.Reset(device);
+        for (int f = 0; f < 20; ++f) {
+            Present(ring, device, frames, f);
+            for (int k = 0; k < lookahead; ++k)
+                CHECK(Resident(device, frames, f + k) == 1);
+        }
+        CHECK(device.inFlightWrites == 0);
+        CHECK(ring.Stats().stalls == 0);
+        CHECK(ring.Stats().prefetches == static_cast<uint64_t>(lookahead > 1 ? 19 + lookahead - 1 : 0));
+    }
+}
+
+TEST(RingShowSkipsFrames) {
+    // Playback that outruns the display skips frames, and seeks jump
+    // backwards; prefetched frames go unused but nothing in flight is
+    // overwritten and every shown frame is right
+    for (bool sparse : { false, true }) {
+        std::vector<VoxelGrid<float>> frames = Sequence(80, sparse);
+        FakeVolumeDevice device(5, 2, 16, 16, 16);
+        VolumeRing ring;
+        ring.lookahead = 3;
+        ring.Reset(device);
+        const int keys[] = { 0, 1, 3, 6, 10, 11, 12, 20, 21, 5, 6, 7, 8, 40, 44, 48, 52, 53, 54, 55 };
+        for (int key : keys)
+            Present(ring, device, frames, key);
+
+        CHECK(device.inFlightWrites == 0);
+        CHECK(ring.Stats().stalls == 0);
+        CHECK(ring.Stats().misses > 1);
+        CHECK(ring.Stats().hits > 1);
+    }
+}
+
+TEST(RingRepeatsShownFrame) {
+    // Paused: the same frame is shown every display frame without uploads
+    std::vector<VoxelGrid<float>> frames = Sequence(4, false);
+    FakeVolumeDevice device(3, 2, 16, 16, 16);
+    VolumeRing ring;
+    ring.lookahead = 1;
+    ring.Reset(device);
+    for (int i = 0; i < 10; ++i)
+        Present(ring, device, frames, 2);
+    CHECK(ring.Stats().misses == 1);
+    CHECK(ring.Stats().hits == 9);
+    CHECK(ring.Uploads().Uploads() == 1);
+    CHECK(device.inFlightWrites == 0);
+}
+
+TEST(RingTooShallowStallsVisibly) {
+    // With fewer slots than the GPU keeps busy, Show has to write a slot
+    // still in flight; each such write is reported as a stall and Prefetch
+    // never does it
+    std::vector<VoxelGrid<float>> frames = Sequence(30, false);
+    FakeVolumeDevice device(2, 3, 16, 16, 16);
+    VolumeRing ring;
+    ring.lookahead = 2;
+    ring.Reset(device);
+    for (int f = 0; f < 30; ++f)
+        Present(ring, device, frames, f);
+
+    CHECK(device.inFlightWrites > 0);
+    CHECK(static_cast<uint64_t>(device.inFlightWrites) <= ring.Stats().stalls);
+}
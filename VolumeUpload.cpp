@@ -0,0 +1,234 @@
+#include "VolumeUpload.hpp"
+#include "BrickDiff.hpp"
+#include "ParallelFor.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VOLUME_UPLOAD_SSE2 1
+#endif
+
+namespace {
+
+// Below this a single memcpy beats waking the worker pool
+const size_t parallelCopyBytes = 1 << 20;
+
+// Longest run of frames the scheduler's CPU copy sits out
+const int maxShadowBackoff = 32;
+
+void CopyFloats(float* dst, const float* src, size_t count) {
+#ifdef VOLUME_UPLOAD_SSE2
+    size_t i = 0;
+    while (i < count && (reinterpret_cast<uintptr_t>(dst + i) & 15) != 0) {
+        dst[i] = src[i];
+        ++i;
+    }
+    for (; i + 16 <= count; i += 16) {
+        _mm_stream_ps(dst + i, _mm_loadu_ps(src + i));
+        _mm_stream_ps(dst + i + 4, _mm_loadu_ps(src + i + 4));
+        _mm_stream_ps(dst + i + 8, _mm_loadu_ps(src + i + 8));
+        _mm_stream_ps(dst + i + 12, _mm_loadu_ps(src + i + 12));
+    }
+    for (; i + 4 <= count; i += 4)
+        _mm_stream_ps(dst + i, _mm_loadu_ps(src + i));
+    for (; i < count; ++i)
+        dst[i] = src[i];
+#else
+    std::memcpy(dst, src, count * sizeof(float));
+#endif
+}
+
+void StoreFence() {
+#ifdef VOLUME_UPLOAD_SSE2
+    _mm_sfence();
+#endif
+}
+
+void CopySlices(const float* src, int width, int height, const MappedVolume& dst, int z0, int z1) {
+    const size_t row = static_cast<size_t>(width);
+    const size_t slice = row * height;
+    char* base = static_cast<char*>(dst.data);
+
+    if (dst.rowPitch == row * sizeof(float) && dst.depthPitch == slice * sizeof(float)) {
+        // Tightly packed: the whole slice range is one contiguous block
+        CopyFloats(reinterpret_cast<float*>(base + z0 * dst.depthPitch), src + z0 * slice, (z1 - z0) * slice);
+    }
+    else {
+        for (int z = z0; z < z1; ++z)
+            for (int y = 0; y < height; ++y)
+                CopyFloats(reinterpret_cast<float*>(base + z * dst.depthPitch + y * dst.rowPitch),
+                    src + z * slice + y * row, row);
+    }
+
+    // Streaming stores are weakly ordered; publish them before Unmap
+    StoreFence();
+}
+
+}
+
+void CopyToMapped(const float* src, int width, int height, int depth, const MappedVolume& dst) {
+    size_t bytes = static_cast<size_t>(width) * height * depth * sizeof(float);
+    if (bytes < parallelCopyBytes) {
+        CopySlices(src, width, height, dst, 0, depth);
+        return;
+    }
+
+    ParallelFor(depth, [&](int z0, int z1) {
+        CopySlices(src, width, height, dst, z0, z1);
+    });
+}
+
+bool VolumeUploadScheduler::Upload(IVolumeUploadTarget& target, const VoxelGrid<float>& frame, int64_t key) {
+    TargetState* state = &StateOf(target);
+    if (state->valid && state->frame == &frame && state->key == key) {
+        skipped++;
+        return false;
+    }
+
+    if (frame.Width() != target.Width() || frame.Height() != target.Height() || frame.Depth() != target.Depth())
+        return false;
+
+    if (!target.SupportsBoxes() || partialFraction <= 0.0f) {
+        state->valid = false;
+        if (!UploadFull(target, frame))
+            return false;
+    }
+    else {
+        Track(frame, key);
+        state = &StateOf(target);
+
+        const bool tracked = shadowValid && shadowFrame == &frame && shadowKey == key;
+        const int changed = state->valid && !state->stale && tracked ? state->changed.ActiveCount() : -1;
+        state->valid = false;
+        if (changed == 0) {
+            skipped++; // New key, same contents
+        }
+        else if (changed > 0 && changed <= partialFraction * state->changed.BrickCount()) {
+            UploadBoxes(target, frame, state->changed);
+        }
+        else if (!UploadFull(target, frame)) {
+            return false;
+        }
+
+        // The target now holds the shadow's contents, unless the shadow is
+        // sitting out a back-off
+        state->stale = !tracked;
+        if (state->changed.BrickCount() != dirty.BrickCount())
+            state->changed = BrickMask(frame.Width(), frame.Height(), frame.Depth());
+        state->changed.Clear();
+    }
+
+    state->valid = true;
+    state->frame = &frame;
+    state->key = key;
+    return true;
+}
+
+void VolumeUploadScheduler::Invalidate() {
+    targets.clear();
+    // A reloaded sequence may put new contents at the shadowed frame's
+    // address under the same key
+    shadowValid = false;
+    shadowFrame = nullptr;
+    shadowWait = 0;
+    shadowBackoff = 1;
+}
+
+VolumeUploadScheduler::TargetState& VolumeUploadScheduler::StateOf(const IVolumeUploadTarget& target) {
+    for (TargetState& state : targets)
+        if (state.target == &target)
+            return state;
+    TargetState& state = targets.emplace_back();
+    state.target = &target;
+    return state;
+}
+
+void VolumeUploadScheduler::Track(const VoxelGrid<float>& frame, int64_t key) {
+    if (shadowValid && shadowFrame == &frame && shadowKey == key)
+        return;
+
+    if (shadow.Width() != frame.Width() || shadow.Height() != frame.Height() || shadow.Depth() != frame.Depth()) {
+        shadow = VoxelGrid<float>(frame.Width(), frame.Height(), frame.Depth());
+        dirty = BrickMask(frame.Width(), frame.Height(), frame.Depth());
+        shadowValid = false;
+        for (TargetState& state : targets)
+            state.stale = true;
+    }
+
+    if (!shadowValid) {
+        if (shadowWait > 0) {
+            shadowWait--;
+            return;
+        }
+        std::memcpy(shadow.Data(), frame.Data(), frame.Size() * sizeof(float));
+        shadowBytes += frame.Size() * sizeof(float);
+        shadowValid = true;
+        shadowFrame = &frame;
+        shadowKey = key;
+        return;
+    }
+
+    // Past this many changed bricks every target takes the full path anyway,
+    // so the diff stops there
+    const int limit = static_cast<int>(partialFraction * dirty.BrickCount());
+    if (!DiffBricks(shadow, frame, dirty, limit)) {
+        shadowValid = false;
+        shadowWait = shadowBackoff;
+        shadowBackoff = std::min(shadowBackoff * 2, maxShadowBackoff);
+        for (TargetState& state : targets)
+            state.stale = true;
+        return;
+    }
+    shadowBackoff = 1;
+
+    dirty.ActiveList(changedBricks);
+    for (TargetState& state : targets) {
+        if (state.stale)
+            continue;
+        if (state.changed.BrickCount() != dirty.BrickCount())
+            state.changed = BrickMask(frame.Width(), frame.Height(), frame.Depth());
+        for (int b : changedBricks)
+            state.changed.Set(b);
+    }
+
+    for (int b : changedBricks) {
+        BrickRange r = dirty.Bounds(b);
+        size_t rowBytes = (r.x1 - r.x0) * sizeof(float);
+        for (int z = r.z0; z < r.z1; ++z)
+            for (int y = r.y0; y < r.y1; ++y)
+                std::memcpy(&shadow.At(r.x0, y, z), &frame.At(r.x0, y, z), rowBytes);
+        shadowBytes += r.Voxels() * sizeof(float);
+    }
+    shadowFrame = &frame;
+    shadowKey = key;
+}
+
+bool VolumeUploadScheduler::UploadFull(IVolumeUploadTarget& target, const VoxelGrid<float>& frame) {
+    MappedVolume mapped;
+    if (!target.Map(mapped))
+        return false;
+
+    CopyToMapped(frame.Data(), frame.Width(), frame.Height(), frame.Depth(), mapped);
+    target.Unmap();
+
+    uploads++;
+    bytes += frame.Size() * sizeof(float);
+    return true;
+}
+
+void VolumeUploadScheduler::UploadBoxes(IVolumeUploadTarget& target, const VoxelGrid<float>& frame, const BrickMask& changed) {
+    CoalesceBricks(changed, boxes);
+
+    const size_t row = static_cast<size_t>(frame.Width());
+    const size_t slice = row * frame.Height();
+    for (const BrickRange& box : boxes) {
+        target.UpdateBox(box, &frame.At(box.x0, box.y0, box.z0), row * sizeof(float), slice * sizeof(float));
+        bytes += box.Voxels() * sizeof(float);
+    }
+
+    uploads++;
+    partialUploads++;
+    boxesIssued += boxes.size();
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BrickMask.hpp"
+#include "VoxelGrid.hpp"
+
+// CPU view of a mapped volume, laid out like D3D11_MAPPED_SUBRESOURCE.
+struct MappedVolume {
+    void* data = nullptr;
+    size_t rowPitch = 0;
+    size_t depthPitch = 0;
+};
+
+// Somewhere a density volume can be written, e.g. a 3D texture.
+// Kept free of D3D types so the upload logic can run against a fake target.
+class IVolumeUploadTarget {
+public:
+    virtual ~IVolumeUploadTarget() = default;
+
+    virtual int Width() const = 0;
+    virtual int Height() const = 0;
+    virtual int Depth() const = 0;
+
+    // Maps the whole volume for writing; previous contents are discarded.
+    virtual bool Map(MappedVolume& mapped) = 0;
+    virtual void Unmap() = 0;
+
+    // Targets that can overwrite a sub-box in place (UpdateSubresource with a
+    // D3D11_BOX) return true and implement UpdateBox. `src` points at the box
+    // origin inside a tightly packed volume with the given pitches.
+    virtual bool SupportsBoxes() const { return false; }
+    virtual void UpdateBox(const BrickRange& /*box*/, const float* /*src*/, size_t /*rowPitch*/, size_t /*depthPitch*/) {}
+};
+
+// Copies a tightly packed width x height x depth float volume into `dst`,
+// honouring its row and depth pitch. Large volumes are split by slices across
+// ParallelFor workers and written with non-temporal stores, since mapped
+// upload memory is write-combined and never read back.
+void CopyToMapped(const float* src, int width, int height, int depth, const MappedVolume& dst);
+
+// Tracks what each target currently holds and skips uploads of the same
+// frame, so a paused or slower-than-display source does not re-copy every
+// Render. For targets that support boxes it keeps one CPU copy of the last
+// frame uploaded to any of them, shared by all targets. Each new frame is
+// diffed against that copy once, per brick. Every target keeps a mask of the
+// bricks that changed since its own upload, and receives only those bricks,
+// coalesced into boxes. Mostly-changed frames take the full path.
+class VolumeUploadScheduler {
+public:
+    // Copies `frame` into `target` unless it already holds the frame with this
+    // key. Returns true if the target was updated to `frame`.
+    bool Upload(IVolumeUploadTarget& target, const VoxelGrid<float>& frame, int64_t key);
+
+    // Forget what the targets and the shadow hold, e.g. after the targets
+    // were recreated or a new sequence was loaded.
+    void Invalidate();
+
+    // Above this fraction of changed bricks a full upload is cheaper than
+    // many small boxes. Zero disables partial updates.
+    float partialFraction = 0.5f;
+
+    uint64_t Uploads() const { return uploads; }
+    uint64_t PartialUploads() const { return partialUploads; }
+    uint64_t BoxesIssued() const { return boxesIssued; }
+    uint64_t Skipped() const { return skipped; }
+    uint64_t BytesUploaded() const { return bytes; }
+    uint64_t ShadowBytes() const { return shadowBytes; } // Copied into the CPU copy
+
+private:
+    struct TargetState {
+        const IVolumeUploadTarget* target = nullptr;
+        bool valid = false;
+        const VoxelGrid<float>* frame = nullptr;
+        int64_t key = 0;
+        bool stale = true; // Contents unrelated to the shadow; only a full upload helps
+        BrickMask changed; // Bricks that differ between its contents and the shadow
+    };
+
+    TargetState& StateOf(const IVolumeUploadTarget& target);
+    void Track(const VoxelGrid<float>& frame, int64_t key);
+    bool UploadFull(IVolumeUploadTarget& target, const VoxelGrid<float>& frame);
+    void UploadBoxes(IVolumeUploadTarget& target, const VoxelGrid<float>& frame, const BrickMask& changed);
+
+    std::vector<TargetState> targets;
+
+    // The last frame uploaded to a box-capable target, while valid. Frames
+    // that change almost everywhere stop it being kept up to date, which
+    // would cost a second full copy each; it is picked up again after a
+    // back-off that doubles while that continues.
+    VoxelGrid<float> shadow{ 0, 0, 0 };
+    bool shadowValid = false;
+    const VoxelGrid<float>* shadowFrame = nullptr;
+    int64_t shadowKey = 0;
+    int shadowBackoff = 1;
+    int shadowWait = 0;
+    BrickMask dirty;
+    std::vector<int> changedBricks;
+    std::vector<BrickRange> boxes;
+
+    uint64_t uploads = 0;
+    uint64_t partialUploads = 0;
+    uint64_t boxesIssued = 0;
+    uint64_t skipped = 0;
+    uint64_t bytes = 0;
+    uint64_t shadowBytes = 0;
+};
@@ -0,0 +1,235 @@
+#include "FakeVolume.hpp"
+#include "Tests.hpp"
+#include "VolumeUpload.hpp"
+
+TEST(SchedulerPartialBoxes) {
+    VoxelGrid<float> a = TestVolume(32, 24, 20, 1), b = a;
+    b.At(3, 4, 5) = 7.0f;
+    b.At(30, 23, 19) = 8.0f; // Partial edge brick
+
+    FakeVolumeTarget target(32, 24, 20);
+    VolumeUploadScheduler scheduler;
+    CHECK(scheduler.Upload(target, a, 0));
+    CHECK(target.maps == 1);
+    CHECK(SameVoxels(target.contents, a));
+
+    CHECK(scheduler.Upload(target, b, 1));
+    CHECK(target.maps == 1);
+    CHECK(target.boxesWritten == 2);
+    CHECK(scheduler.PartialUploads() == 1);
+    CHECK(SameVoxels(target.contents, b));
+    CHECK(scheduler.BytesUploaded() == (a.Size() + 8 * 8 * 8 + 8 * 8 * 4) * sizeof(float));
+}
+
+TEST(SchedulerFullFallback) {
+    VoxelGrid<float> a = TestVolume(32, 32, 32, 1), b = TestVolume(32, 32, 32, 2);
+    FakeVolumeTarget target(32, 32, 32, true, 64, 256); // Padded like a driver's mapping
+    VolumeUploadScheduler scheduler;
+    CHECK(scheduler.Upload(target, a, 0));
+    CHECK(scheduler.Upload(target, b, 1));
+    CHECK(target.maps == 2);
+    CHECK(target.boxesWritten == 0);
+    CHECK(scheduler.PartialUploads() == 0);
+    CHECK(SameVoxels(target.contents, b));
+}
+
+TEST(SchedulerThreshold) {
+    // Changing exactly the threshold's worth of bricks still goes partial,
+    // one more goes full
+    VoxelGrid<float> a = TestVolume(32, 32, 32, 1);
+    FakeVolumeTarget target(32, 32, 32);
+    VolumeUploadScheduler scheduler;
+    CHECK(scheduler.Upload(target, a, 0));
+
+    VoxelGrid<float> b = a;
+    const int bricks = 4 * 4 * 4;
+    for (int n = 0; n < bricks / 2; ++n)
+        b.At((n % 4) * 8, (n / 4 % 4) * 8, (n / 16) * 8) += 1.0f;
+    CHECK(scheduler.Upload(target, b, 1));
+    CHECK(target.maps == 1);
+    CHECK(scheduler.PartialUploads() == 1);
+    CHECK(SameVoxels(target.contents, b));
+
+    VoxelGrid<float> c = b;
+    for (int n = 0; n <= bricks / 2; ++n)
+        c.At((n % 4) * 8, (n / 4 % 4) * 8, (n / 16) * 8) += 1.0f;
+    CHECK(scheduler.Upload(target, c, 2));
+    CHECK(target.maps == 2);
+    CHECK(SameVoxels(target.contents, c));
+}
+
+TEST(SchedulerSharedShadowAcrossTargets) {
+    // Two targets fed alternately, as the volume ring does, each get the
+    // bricks changed since their own last upload
+    std::vector<VoxelGrid<float>> frames(1, TestVolume(24, 24, 24, 1));
+    for (int f = 1; f < 8; ++f) {
+        frames.push_back(frames.back());
+        frames.back().At(f * 3 % 24, f * 5 % 24, f * 7 % 24) += 1.0f;
+    }
+
+    FakeVolumeTarget first(24, 24, 24), second(24, 24, 24);
+    VolumeUploadScheduler scheduler;
+    for (int f = 0; f < 8; ++f) {
+        FakeVolumeTarget& target = f % 2 ? second : first;
+        CHECK(scheduler.Upload(target, frames[f], f));
+        CHECK(SameVoxels(target.contents, frames[f]));
+    }
+    CHECK(first.maps == 1 && second.maps == 1);
+    CHECK(scheduler.PartialUploads() == 6);
+    // One full copy into the shadow, then only changed bricks
+    CHECK(scheduler.ShadowBytes() == (frames[0].Size() + 7 * 8 * 8 * 8) * sizeof(float));
+}
+
+TEST(SchedulerShadowBackoff) {
+    // Frames that change everywhere stop the shadow copy; contents stay
+    // right throughout and partial updates resume once frames settle
+    FakeVolumeTarget target(16, 16, 16);
+    VolumeUploadScheduler scheduler;
+    int key = 0;
+    for (int f = 0; f < 12; ++f, ++key) {
+        VoxelGrid<float> frame = TestVolume(16, 16, 16, f);
+        CHECK(scheduler.Upload(target, frame, key));
+        CHECK(SameVoxels(target.contents, frame));
+    }
+    CHECK(scheduler.ShadowBytes() < 12 * 16 * 16 * 16 * sizeof(float) / 2);
+
+    VoxelGrid<float> still = TestVolume(16, 16, 16, 100);
+    for (int f = 0; f < 40; ++f, ++key) {
+        still.At(f % 16, 0, 0) += 1.0f;
+        CHECK(scheduler.Upload(target, still, key));
+        CHECK(SameVoxels(target.contents, still));
+    }
+    CHECK(scheduler.PartialUploads() > 0);
+}
+
+TEST(SchedulerFullOnlyTarget) {
+    VoxelGrid<float> a = TestVolume(16, 16, 16, 1), b = a;
+    b.At(0, 0, 0) = 5.0f;
+    FakeVolumeTarget target(16, 16, 16, false);
+    VolumeUploadScheduler scheduler;
+    CHECK(scheduler.Upload(target, a, 0));
+    CHECK(scheduler.Upload(target, b, 1));
+    CHECK(target.maps == 2);
+    CHECK(scheduler.ShadowBytes() == 0);
+    CHECK(SameVoxels(target.contents, b));
+}
+
+TEST(SchedulerSkipsSameFrame) {
+    // Paused playback hands the same frame and key to every Render
+    VoxelGrid<float> a = TestVolume(16, 16, 16, 1);
+    for (bool boxes : { false, true }) {
+        FakeVolumeTarget target(16, 16, 16, boxes);
+        VolumeUploadScheduler scheduler;
+        CHECK(scheduler.Upload(target, a, 5));
+        for (int i = 0; i < 10; ++i)
+            CHECK(!scheduler.Upload(target, a, 5));
+        CHECK(target.maps == 1);
+        CHECK(target.boxesWritten == 0);
+        CHECK(scheduler.Uploads() == 1);
+        CHECK(scheduler.Skipped() == 10);
+        CHECK(scheduler.BytesUploaded() == a.Size() * sizeof(float));
+    }
+}
+
+TEST(SchedulerUploadsNewKey) {
+    // The same grid object refilled with another frame carries a new key
+    VoxelGrid<float> frame = TestVolume(16, 16, 16, 1);
+    FakeVolumeTarget target(16, 16, 16, false);
+    VolumeUploadScheduler scheduler;
+    CHECK(scheduler.Upload(target, frame, 0));
+    frame = TestVolume(16, 16, 16, 2);
+    CHECK(scheduler.Upload(target, frame, 1));
+    CHECK(target.maps == 2);
+    CHECK(SameVoxels(target.contents, frame));
+}
+
+TEST(SchedulerSkipsUnchangedContents) {
+    // A new key whose voxels match what a box target already holds costs
+    // nothing beyond the diff
+    VoxelGrid<float> a = TestVolume(16, 16, 16, 1), b = a;
+    FakeVolumeTarget target(16, 16, 16);
+    VolumeUploadScheduler scheduler;
+    CHECK(scheduler.Upload(target, a, 0));
+    CHECK(scheduler.Upload(target, b, 1));
+    CHECK(target.maps == 1);
+    CHECK(target.boxesWritten == 0);
+    CHECK(scheduler.Skipped() == 1);
+    CHECK(SameVoxels(target.contents, b));
+}
+
+TEST(SchedulerInvalidate) {
+    // A reloaded sequence reuses the old frames' storage and keys, so
+    // nothing of the old one may be taken for the new
+    std::vector<VoxelGrid<float>> frames(2, TestVolume(16, 16, 16, 1));
+    FakeVolumeTarget target(16, 16, 16);
+    VolumeUploadScheduler scheduler;
+    CHECK(scheduler.Upload(target, frames[0], 0));
+    scheduler.Invalidate();
+
+    const VoxelGrid<float> a = frames[0];
+    frames[0].At(0, 0, 0) += 1.0f;
+    frames[1] = a;
+    frames[1].At(8, 8, 8) += 1.0f; // Back to the old contents in the first brick
+    CHECK(scheduler.Upload(target, frames[0], 0));
+    CHECK(target.maps == 2);
+    CHECK(SameVoxels(target.contents, frames[0]));
+    CHECK(scheduler.Upload(target, frames[1], 1));
+    CHECK(SameVoxels(target.contents, frames[1]));
+}
+
+TEST(SchedulerRejectsMismatchedTarget) {
+    VoxelGrid<float> a = TestVolume(16, 16, 16, 1);
+    FakeVolumeTarget target(16, 16, 8);
+    VolumeUploadScheduler scheduler;
+    CHECK(!scheduler.Upload(target, a, 0));
+    CHECK(target.maps == 0);
+}
+
+namespace {
+
+// Copies `src` into a buffer with the given padding, whose padding bytes
+// must come through untouched
+bool CopiesWithPitch(int x, int y, int z, size_t rowPadding, size_t slicePadding) {
+    VoxelGrid<float> src = TestVolume(x, y, z, 7);
+    const size_t rowPitch = x * sizeof(float) + rowPadding;
+    const size_t depthPitch = rowPitch * y + slicePadding;
+    const unsigned char sentinel = 0xCD;
+    std::vector<unsigned char> buffer(depthPitch * z + 64, sentinel);
+
+    MappedVolume mapped;
+    mapped.data = buffer.data();
+    mapped.rowPitch = rowPitch;
+    mapped.depthPitch = depthPitch;
+    CopyToMapped(src.Data(), x, y, z, mapped);
+
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        const size_t zi = i / depthPitch, inSlice = i % depthPitch;
+        const size_t yi = inSlice / rowPitch, inRow = inSlice % rowPitch;
+        const bool voxel = zi < static_cast<size_t>(z) && yi < static_cast<size_t>(y) && inRow < x * sizeof(float);
+        if (!voxel && buffer[i] != sentinel)
+            return false;
+    }
+    for (int k = 0; k < z; ++k)
+        for (int j = 0; j < y; ++j)
+            if (std::memcmp(buffer.data() + k * depthPitch + j * rowPitch, &src.At(0, j, k), x * sizeof(float)) != 0)
+                return false;
+    return true;
+}
+
+}
+
+TEST(CopyToMappedSmall) {
+    // 16 KB: copied on the calling thread
+    CHECK(CopiesWithPitch(16, 16, 16, 0, 0));
+    CHECK(CopiesWithPitch(16, 16, 16, 64, 0));
+    CHECK(CopiesWithPitch(16, 16, 16, 64, 512));
+    CHECK(CopiesWithPitch(13, 7, 5, 12, 20)); // Rows that are not 16-byte aligned
+}
+
+TEST(CopyToMappedLarge) {
+    // Over the 1 MB split: slices go to ParallelFor workers
+    CHECK(CopiesWithPitch(72, 64, 60, 0, 0));
+    CHECK(CopiesWithPitch(72, 64, 60, 224, 0));
+    CHECK(CopiesWithPitch(72, 64, 60, 224, 4096));
+    CHECK(CopiesWithPitch(67, 65, 61, 20, 36));
+}
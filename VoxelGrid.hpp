@@ -1,3 +1,6 @@
+#pragma once
+
+#include <algorithm>
 #include <vector>
 #include "Vector3.hpp"
 
@@ -14,6 +17,14 @@ public:
     T* Data();
     const T* Data() const;
 
+    // Trilinear sample in voxel coordinates, clamped to the grid
+    T Sample(float x, float y, float z) const;
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    int Depth() const { return depth; }
+    size_t Size() const { return grid.size(); }
+
 private:
     std::vector<T> grid; // Single flat vector
     int width, height, depth;
@@ -61,6 +72,26 @@ const T* VoxelGrid<T>::Data() const {
     return grid.data();
 }
 
+template <typename T>
+T VoxelGrid<T>::Sample(float x, float y, float z) const {
+    x = std::clamp(x, 0.0f, static_cast<float>(width - 1));
+    y = std::clamp(y, 0.0f, static_cast<float>(height - 1));
+    z = std::clamp(z, 0.0f, static_cast<float>(depth - 1));
+
+    int x0 = static_cast<int>(x), y0 = static_cast<int>(y), z0 = static_cast<int>(z);
+    int x1 = std::min(x0 + 1, width - 1), y1 = std::min(y0 + 1, height - 1), z1 = std::min(z0 + 1, depth - 1);
+    float fx = x - x0, fy = y - y0, fz = z - z0;
+
+    T c00 = grid[Index(x0, y0, z0)] * (1 - fx) + grid[Index(x1, y0, z0)] * fx;
+    T c10 = grid[Index(x0, y1, z0)] * (1 - fx) + grid[Index(x1, y1, z0)] * fx;
+    T c01 = grid[Index(x0, y0, z1)] * (1 - fx) + grid[Index(x1, y0, z1)] * fx;
+    T c11 = grid[Index(x0, y1, z1)] * (1 - fx) + grid[Index(x1, y1, z1)] * fx;
+
+    T c0 = c00 * (1 - fy) + c10 * fy;
+    T c1 = c01 * (1 - fy) + c11 * fy;
+    return c0 * (1 - fz) + c1 * fz;
+}
+
 template <typename T>
 int VoxelGrid<T>::Index(int x, int y, int z) const {
     return x + width * (y + height * z);